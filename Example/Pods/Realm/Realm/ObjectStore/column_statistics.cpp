@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "column_statistics.hpp"
+
+#include <realm/group.hpp>
+#include <realm/table.hpp>
+#include <realm/table_view.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace realm;
+
+namespace {
+const char * const c_statisticsTableName = "statistics";
+const size_t c_tableColumnIndex = 0;
+const size_t c_columnColumnIndex = 1;
+const size_t c_rowCountColumnIndex = 2;
+const size_t c_nullCountColumnIndex = 3;
+const size_t c_distinctCountColumnIndex = 4;
+const size_t c_minColumnIndex = 5;
+const size_t c_maxColumnIndex = 6;
+const size_t c_histogramColumnIndex = 7;
+
+uint64_t mix(uint64_t h)
+{
+    // splitmix64 finalizer
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t hash(StringData s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+    for (size_t i = 0; i < s.size(); ++i) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+uint64_t hash(double d)
+{
+    if (d == 0)
+        d = 0; // fold -0.0 into 0.0
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof bits);
+    return mix(bits);
+}
+
+// HyperLogLog with 256 registers, which estimates the number of distinct
+// values to within about 7% using 256 bytes
+class DistinctCounter {
+public:
+    void add(uint64_t hash)
+    {
+        size_t bucket = hash >> 56;
+        uint64_t rest = hash << 8;
+        uint8_t rank = 1;
+        while (rank <= 56 && !(rest & (uint64_t(1) << 63))) {
+            rest <<= 1;
+            ++rank;
+        }
+        m_registers[bucket] = std::max(m_registers[bucket], rank);
+    }
+
+    size_t estimate() const
+    {
+        const double m = m_registers.size();
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : m_registers) {
+            sum += std::ldexp(1.0, -r);
+            zeros += r == 0;
+        }
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros)
+            estimate = m * std::log(m / zeros);
+        return size_t(std::llround(estimate));
+    }
+
+private:
+    std::array<uint8_t, 256> m_registers{};
+};
+
+bool is_numeric(DataType type)
+{
+    switch (type) {
+        case type_Int:
+        case type_Bool:
+        case type_Float:
+        case type_Double:
+        case type_Timestamp:
+        case type_OldDateTime:
+            return true;
+        default:
+            return false;
+    }
+}
+
+double numeric_value(const Table& table, DataType type, size_t column, size_t row)
+{
+    switch (type) {
+        case type_Int:         return double(table.get_int(column, row));
+        case type_Bool:        return table.get_bool(column, row) ? 1 : 0;
+        case type_Float:       return table.get_float(column, row);
+        case type_Double:      return table.get_double(column, row);
+        case type_OldDateTime: return double(table.get_olddatetime(column, row).get_olddatetime());
+        case type_Timestamp: {
+            Timestamp ts = table.get_timestamp(column, row);
+            return double(ts.get_seconds()) + ts.get_nanoseconds() / 1e9;
+        }
+        default:
+            REALM_UNREACHABLE();
+    }
+}
+
+TableRef statistics_table(Group& group)
+{
+    TableRef table = group.get_or_add_table(c_statisticsTableName);
+    if (table->get_column_count() == 0) {
+        table->add_column(type_String, "table");
+        table->add_column(type_String, "column");
+        table->add_column(type_Int, "row_count");
+        table->add_column(type_Int, "null_count");
+        table->add_column(type_Int, "distinct_count");
+        table->add_column(type_Double, "min");
+        table->add_column(type_Double, "max");
+        table->add_column(type_Binary, "histogram");
+        table->add_search_index(c_tableColumnIndex);
+    }
+    return table;
+}
+
+size_t find(const Table& stats_table, StringData table_name, StringData column_name)
+{
+    auto rows = stats_table.find_all_string(c_tableColumnIndex, table_name);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        size_t row = rows.get_source_ndx(i);
+        if (stats_table.get_string(c_columnColumnIndex, row) == column_name)
+            return row;
+    }
+    return not_found;
+}
+
+void store(Table& stats_table, StringData table_name, StringData column_name, ColumnStatistics const& stats)
+{
+    size_t row = find(stats_table, table_name, column_name);
+    if (row == not_found) {
+        row = stats_table.add_empty_row();
+        stats_table.set_string(c_tableColumnIndex, row, table_name);
+        stats_table.set_string(c_columnColumnIndex, row, column_name);
+    }
+
+    int64_t histogram[ColumnStatistics::histogram_size];
+    std::copy(stats.histogram.begin(), stats.histogram.end(), histogram);
+
+    stats_table.set_int(c_rowCountColumnIndex, row, stats.row_count);
+    stats_table.set_int(c_nullCountColumnIndex, row, stats.null_count);
+    stats_table.set_int(c_distinctCountColumnIndex, row, stats.distinct_count);
+    stats_table.set_double(c_minColumnIndex, row, stats.min);
+    stats_table.set_double(c_maxColumnIndex, row, stats.max);
+    stats_table.set_binary(c_histogramColumnIndex, row,
+                           BinaryData(reinterpret_cast<const char*>(histogram), sizeof histogram));
+}
+} // anonymous namespace
+
+ColumnStatistics ColumnStatistics::compute(const Table& table, size_t column)
+{
+    ColumnStatistics stats;
+    stats.row_count = table.size();
+
+    DataType type = table.get_column_type(column);
+    bool nullable = table.is_nullable(column);
+    DistinctCounter distinct;
+
+    if (type == type_String) {
+        for (size_t row = 0; row < stats.row_count; ++row) {
+            StringData value = table.get_string(column, row);
+            if (value.is_null())
+                ++stats.null_count;
+            else
+                distinct.add(hash(value));
+        }
+        stats.distinct_count = distinct.estimate();
+        return stats;
+    }
+
+    if (!is_numeric(type))
+        return stats;
+
+    stats.min = std::numeric_limits<double>::infinity();
+    stats.max = -std::numeric_limits<double>::infinity();
+    for (size_t row = 0; row < stats.row_count; ++row) {
+        if (nullable && table.is_null(column, row)) {
+            ++stats.null_count;
+            continue;
+        }
+        double value = numeric_value(table, type, column, row);
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+        distinct.add(hash(value));
+    }
+    stats.distinct_count = distinct.estimate();
+
+    if (stats.null_count == stats.row_count) {
+        stats.min = stats.max = 0;
+        return stats;
+    }
+
+    double width = (stats.max - stats.min) / histogram_size;
+    for (size_t row = 0; row < stats.row_count; ++row) {
+        if (nullable && table.is_null(column, row))
+            continue;
+        double value = numeric_value(table, type, column, row);
+        size_t bucket = width > 0 ? size_t((value - stats.min) / width) : 0;
+        ++stats.histogram[std::min(bucket, histogram_size - 1)];
+    }
+    return stats;
+}
+
+double ColumnStatistics::estimate_equal() const
+{
+    if (row_count == 0 || distinct_count == 0)
+        return 0;
+    return double(row_count - null_count) / distinct_count / row_count;
+}
+
+double ColumnStatistics::estimate_equal(double value) const
+{
+    if (row_count == 0 || value < min || value > max)
+        return 0;
+    if (distinct_count == 0)
+        return 0;
+
+    // Assume the values in the value's bucket are spread evenly over the
+    // distinct values falling in that bucket
+    double width = (max - min) / histogram_size;
+    size_t bucket = width > 0 ? std::min(size_t((value - min) / width), histogram_size - 1) : 0;
+    double distinct_in_bucket = std::max(1.0, double(distinct_count) * histogram[bucket] / (row_count - null_count));
+    return histogram[bucket] / distinct_in_bucket / row_count;
+}
+
+double ColumnStatistics::estimate_range(double low, double high) const
+{
+    if (row_count == 0 || high < min || low > max || low > high)
+        return 0;
+
+    double width = (max - min) / histogram_size;
+    if (width <= 0)
+        return double(row_count - null_count) / row_count;
+
+    // Count whole buckets inside the range, and the overlapping part of the
+    // buckets at either end assuming values are uniform within a bucket
+    double matches = 0;
+    for (size_t i = 0; i < histogram_size; ++i) {
+        double bucket_low = min + i * width;
+        double bucket_high = bucket_low + width;
+        double overlap = std::min(high, bucket_high) - std::max(low, bucket_low);
+        if (overlap > 0)
+            matches += histogram[i] * std::min(1.0, overlap / width);
+    }
+    return std::min(1.0, matches / row_count);
+}
+
+void ColumnStatistics::update(Group& group, StringData table_name)
+{
+    ConstTableRef table = group.get_table(table_name);
+    if (!table)
+        return;
+
+    // Copy the name, as adding the statistics table may invalidate it
+    std::string name = table_name;
+    TableRef stats_table = statistics_table(group);
+    for (size_t col = 0; col < table->get_column_count(); ++col) {
+        DataType type = table->get_column_type(col);
+        if (type != type_String && !is_numeric(type))
+            continue;
+        store(*stats_table, name, table->get_column_name(col), compute(*table, col));
+    }
+}
+
+bool ColumnStatistics::is_stale(const Group& group, StringData table_name)
+{
+    ConstTableRef table = group.get_table(table_name);
+    if (!table)
+        return false;
+    ConstTableRef stats_table = group.get_table(c_statisticsTableName);
+    if (!stats_table)
+        return true;
+
+    // All columns of a table are computed together, so any row will do
+    size_t row = stats_table->find_first_string(c_tableColumnIndex, table_name);
+    if (row == not_found)
+        return true;
+
+    size_t old_count = size_t(stats_table->get_int(c_rowCountColumnIndex, row));
+    size_t new_count = table->size();
+    size_t drift = new_count > old_count ? new_count - old_count : old_count - new_count;
+    return drift > std::max<size_t>(old_count / 4, 16);
+}
+
+util::Optional<ColumnStatistics> ColumnStatistics::get(const Group& group, StringData table_name,
+                                                       StringData column_name)
+{
+    ConstTableRef stats_table = group.get_table(c_statisticsTableName);
+    if (!stats_table)
+        return util::none;
+
+    size_t row = find(*stats_table, table_name, column_name);
+    if (row == not_found)
+        return util::none;
+
+    ColumnStatistics stats;
+    stats.row_count = size_t(stats_table->get_int(c_rowCountColumnIndex, row));
+    stats.null_count = size_t(stats_table->get_int(c_nullCountColumnIndex, row));
+    stats.distinct_count = size_t(stats_table->get_int(c_distinctCountColumnIndex, row));
+    stats.min = stats_table->get_double(c_minColumnIndex, row);
+    stats.max = stats_table->get_double(c_maxColumnIndex, row);
+
+    BinaryData histogram = stats_table->get_binary(c_histogramColumnIndex, row);
+    int64_t buckets[histogram_size] = {};
+    std::memcpy(buckets, histogram.data(), std::min(histogram.size(), sizeof buckets));
+    std::copy(buckets, buckets + histogram_size, stats.histogram.begin());
+    return stats;
+}
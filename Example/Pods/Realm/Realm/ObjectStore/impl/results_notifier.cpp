@@ -140,7 +140,7 @@ void ResultsNotifier::run()
     m_query->sync_view_if_needed();
     m_tv = m_query->find_all();
     if (m_sort) {
-        m_tv.sort(m_sort.column_indices, m_sort.ascending);
+        m_tv.sort_by_keys(m_sort.column_indices, m_sort.ascending);
     }
     m_last_seen_version = m_tv.sync_if_needed();
 
@@ -518,7 +518,9 @@ void ObjectStore::validate_primary_column_uniqueness(const Group *group, Schema
         }
 
         ConstTableRef table = table_for_object_type(group, object_schema.name);
-        if (table->get_distinct_view(primary_prop->table_column).size() != table->size()) {
+        ConstTableView rows = table->where().find_all();
+        rows.distinct_by_keys({primary_prop->table_column});
+        if (rows.size() != table->size()) {
             throw DuplicatePrimaryKeyValueException(object_schema.name, *primary_prop);
         }
     }
@@ -26,6 +26,25 @@
 
 using namespace realm;
 
+namespace {
+// Build a sort predicate which compares rows of `table` directly rather than
+// going through the row indexes of a TableView
+RowIndexes::Sorter make_table_sorter(const Table& table, SortOrder const& sort)
+{
+    RowIndexes::Sorter sorter(sort.column_indices, sort.ascending);
+    sorter.m_columns.resize(sort.column_indices.size(), nullptr);
+    sorter.m_string_enum_columns.resize(sort.column_indices.size(), nullptr);
+    for (size_t i = 0; i < sort.column_indices.size(); ++i) {
+        const ColumnBase& cb = _impl::TableFriend::get_column(table, sort.column_indices[i]);
+        if (auto cse = dynamic_cast<const StringEnumColumn*>(&cb))
+            sorter.m_string_enum_columns[i] = cse;
+        else
+            sorter.m_columns[i] = &dynamic_cast<const ColumnTemplateBase&>(cb);
+    }
+    return sorter;
+}
+} // anonymous namespace
+
 #ifdef __has_cpp_attribute
 #define REALM_HAS_CCP_ATTRIBUTE(attr) __has_cpp_attribute(attr)
 #else
@@ -167,6 +186,9 @@ util::Optional<RowExpr> Results::first()
                 return m_link_view->size() == 0 ? util::none : util::make_optional(m_link_view->get(0));
             REALM_FALLTHROUGH;
         case Mode::Query:
+            if (can_query_directly())
+                return find_extreme_row(true);
+            REALM_FALLTHROUGH;
         case Mode::TableView:
             update_tableview();
             return m_table_view.size() == 0 ? util::none : util::make_optional(m_table_view.front());
@@ -187,6 +209,9 @@ util::Optional<RowExpr> Results::last()
                 return m_link_view->size() == 0 ? util::none : util::make_optional(m_link_view->get(m_link_view->size() - 1));
             REALM_FALLTHROUGH;
         case Mode::Query:
+            if (can_query_directly())
+                return find_extreme_row(false);
+            REALM_FALLTHROUGH;
         case Mode::TableView:
             update_tableview();
             return m_table_view.size() == 0 ? util::none : util::make_optional(m_table_view.back());
@@ -194,6 +219,52 @@ util::Optional<RowExpr> Results::last()
     REALM_UNREACHABLE();
 }
 
+bool Results::can_query_directly() const
+{
+    // With a restricting view the match order is the view's order, which
+    // find() does not let us walk, so only table-ordered queries qualify
+    return m_mode == Mode::Query && m_query.produces_results_in_table_order();
+}
+
+util::Optional<RowExpr> Results::find_extreme_row(bool first)
+{
+    m_query.sync_view_if_needed();
+
+    if (!m_sort) {
+        if (first) {
+            size_t row = m_query.find();
+            return row == not_found ? util::none : util::make_optional(m_table->get(row));
+        }
+        // There's no reverse find(), so search backwards from the end of the
+        // table in windows of doubling size, which needs only a logarithmic
+        // number of query runs and stops at the window holding the last match
+        size_t end = m_table->size();
+        for (size_t window = 1024; end > 0; window *= 2) {
+            size_t begin = end > window ? end - window : 0;
+            TableView tv = m_query.find_all(begin, end);
+            if (tv.size() != 0)
+                return util::make_optional(m_table->get(tv.get_source_ndx(tv.size() - 1)));
+            end = begin;
+        }
+        return none;
+    }
+
+    // Single pass over the matches keeping the row which would end up at the
+    // front (or back) after a stable sort, without building a TableView
+    auto sorter = make_table_sorter(*m_table, m_sort);
+    size_t best = not_found;
+    QueryCursor cursor(m_query);
+    std::vector<size_t> rows;
+    while (cursor.next(rows)) {
+        for (size_t row : rows) {
+            // Ties go to the earliest row for first() and the latest for last()
+            if (best == not_found || (first ? sorter(row, best) : !sorter(row, best)))
+                best = row;
+        }
+    }
+    return best == not_found ? util::none : util::make_optional(m_table->get(best));
+}
+
 bool Results::update_linkview()
 {
     if (m_sort) {
@@ -217,7 +288,7 @@ void Results::update_tableview()
             m_query.sync_view_if_needed();
             m_table_view = m_query.find_all();
             if (m_sort) {
-                m_table_view.sort(m_sort.column_indices, m_sort.ascending);
+                m_table_view.sort_by_keys(m_sort.column_indices, m_sort.ascending);
             }
             m_mode = Mode::TableView;
             break;
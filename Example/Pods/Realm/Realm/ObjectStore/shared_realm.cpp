@@ -19,6 +19,7 @@
 #include "shared_realm.hpp"
 
 #include "binding_context.hpp"
+#include "column_statistics.hpp"
 #include "impl/realm_coordinator.hpp"
 #include "impl/transact_log_handler.hpp"
 #include "object_store.hpp"
@@ -397,6 +398,23 @@ bool Realm::compact()
     return m_shared_group->compact();
 }
 
+void Realm::update_statistics()
+{
+    begin_transaction();
+    try {
+        for (auto& object_schema : *m_config.schema) {
+            auto table_name = ObjectStore::table_name_for_object_type(object_schema.name);
+            if (ColumnStatistics::is_stale(*m_group, table_name))
+                ColumnStatistics::update(*m_group, table_name);
+        }
+    }
+    catch (...) {
+        cancel_transaction();
+        throw;
+    }
+    commit_transaction();
+}
+
 void Realm::write_copy(StringData path, BinaryData key)
 {
     REALM_ASSERT(!key.data() || key.size() == 64);
@@ -23,9 +23,11 @@
 #import "RLMObjectSchema_Private.hpp"
 #import "RLMPredicateUtil.hpp"
 #import "RLMProperty_Private.h"
+#import "RLMRealm_Private.hpp"
 #import "RLMSchema_Private.h"
 #import "RLMUtil.hpp"
 
+#import "column_statistics.hpp"
 #import "results.hpp"
 
 #include <realm.hpp>
@@ -102,6 +104,133 @@ struct FalseExpression : realm::Expression {
     }
 };
 
+struct BacklinkExpressionHandoverPatch : realm::QueryNodeHandoverPatch {
+    std::unique_ptr<realm::QueryHandoverPatch> target_query;
+};
+
+// Matches the rows of the base table from which a chain of forward links reaches a row matching a query on the last
+// table of the chain. It is evaluated from the far end: the query finds the matching rows, using the search index if
+// there is one, and their backlinks are followed back to the base table. The result is cached until one of the tables
+// along the chain changes.
+class BacklinkExpression : public realm::Expression {
+public:
+    BacklinkExpression(std::vector<size_t> link_columns, Query target_query)
+    : m_link_columns(std::move(link_columns)), m_target_query(new Query(std::move(target_query)))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override
+    {
+        refresh();
+        for (; start < end && start < m_matches.size(); ++start) {
+            if (m_matches[start])
+                return start;
+        }
+        return realm::not_found;
+    }
+
+    // Called each time the query is run, so the chain is only rebuilt for a new table
+    void set_base_table(const Table* table) override
+    {
+        if (table == m_base_table && m_tables.size() == m_link_columns.size() + 1) {
+            return;
+        }
+        m_base_table = table;
+        m_tables.clear();
+        m_versions.clear();
+        if (!table) {
+            return;
+        }
+        m_tables.push_back(table);
+        for (size_t column : m_link_columns) {
+            m_tables.push_back(m_tables.back()->get_link_target(column).get());
+        }
+    }
+    const Table* get_base_table() const override { return m_base_table; }
+
+    std::unique_ptr<Expression> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<Expression>(new BacklinkExpression(*this, patches));
+    }
+
+    void apply_handover_patch(QueryNodeHandoverPatches& patches, Group& group) override
+    {
+        REALM_ASSERT(patches.size());
+        std::unique_ptr<QueryNodeHandoverPatch> abstract_patch = std::move(patches.back());
+        patches.pop_back();
+
+        auto patch = dynamic_cast<BacklinkExpressionHandoverPatch*>(abstract_patch.get());
+        REALM_ASSERT(patch);
+        m_target_query->apply_and_consume_patch(patch->target_query, group);
+    }
+
+private:
+    BacklinkExpression(const BacklinkExpression& source, QueryNodeHandoverPatches* patches)
+    : m_link_columns(source.m_link_columns)
+    , m_base_table(patches ? nullptr : source.m_base_table)
+    {
+        if (m_base_table) {
+            m_tables = source.m_tables;
+        }
+        if (!patches) {
+            m_target_query.reset(new Query(*source.m_target_query));
+            return;
+        }
+
+        std::unique_ptr<BacklinkExpressionHandoverPatch> patch(new BacklinkExpressionHandoverPatch);
+        m_target_query = source.m_target_query->clone_for_handover(patch->target_query, ConstSourcePayload::Copy);
+        patches->emplace_back(patch.release());
+    }
+
+    void refresh() const
+    {
+        const auto& tables = m_tables;
+        bool current = m_versions.size() == tables.size();
+        for (size_t i = 0; current && i < tables.size(); ++i) {
+            current = m_versions[i] == tables[i]->get_version_counter();
+        }
+        if (current) {
+            return;
+        }
+
+        TableView matches = m_target_query->find_all();
+        std::vector<bool> rows(tables.back()->size());
+        for (size_t i = 0; i < matches.size(); ++i)
+            rows[matches.get_source_ndx(i)] = true;
+
+        for (size_t i = m_link_columns.size(); i > 0; --i) {
+            const Table& origin = *tables[i - 1];
+            const Table& target = *tables[i];
+            size_t column = m_link_columns[i - 1];
+
+            std::vector<bool> origin_rows(origin.size());
+            for (size_t row = 0; row < rows.size(); ++row) {
+                if (!rows[row])
+                    continue;
+                size_t count = target.get_backlink_count(row, origin, column);
+                for (size_t j = 0; j < count; ++j)
+                    origin_rows[target.get_backlink(row, origin, column, j)] = true;
+            }
+            rows = std::move(origin_rows);
+        }
+
+        m_matches = std::move(rows);
+        m_versions.resize(tables.size());
+        for (size_t i = 0; i < tables.size(); ++i) {
+            m_versions[i] = tables[i]->get_version_counter();
+        }
+    }
+
+    std::vector<size_t> m_link_columns;
+    std::unique_ptr<Query> m_target_query;
+    const Table* m_base_table = nullptr;
+    // The base table followed by the target table of each link column
+    std::vector<const Table*> m_tables;
+
+    mutable std::vector<uint_fast64_t> m_versions;
+    mutable std::vector<bool> m_matches;
+};
+
 NSString *operatorName(NSPredicateOperatorType operatorType)
 {
     switch (operatorType) {
@@ -190,6 +319,26 @@ public:
         });
     }
 
+    bool has_only_forward_links() const {
+        return std::all_of(begin(m_links), end(m_links), [](RLMProperty *property) {
+            return property.type == RLMPropertyTypeObject || property.type == RLMPropertyTypeArray;
+        });
+    }
+
+    std::vector<size_t> link_column_indexes() const {
+        std::vector<size_t> columns;
+        for (RLMProperty *property : m_links) {
+            columns.push_back(property.column);
+        }
+        return columns;
+    }
+
+    // The schema of the object type the links lead to
+    RLMObjectSchema *object_schema_after_links() const {
+        REALM_ASSERT(m_links.size());
+        return m_schema[m_links.back().objectClassName];
+    }
+
     util::Optional<ColumnReference> last_link_column() const {
         if (!m_links.size()) {
             return util::none;
@@ -960,6 +1109,123 @@ void update_query_with_collection_operator_expression(RLMSchema *schema,
     }
 }
 
+double estimated_selectivity(NSPredicate *predicate, RLMObjectSchema *objectSchema, const Group& group);
+
+// Evaluating "links.property <op> value" walks the links of every row of the base table, which for to-many links
+// costs about a visit to every row of the last table per link in the chain. If the condition is selective it is
+// cheaper to find the matching rows of the last table first and follow their backlinks to the base table. Returns
+// false without modifying the query if the forward evaluation is estimated to be cheaper, or if the condition is one
+// which a missing link could satisfy.
+bool add_backlink_constraint_to_query(realm::Query &query, NSPredicateOperatorType operatorType,
+                                      NSComparisonPredicateOptions predicateOptions,
+                                      const ColumnReference& column, id value)
+{
+    if (!column.has_links() || !column.has_only_forward_links() || !value || value == NSNull.null) {
+        return false;
+    }
+    switch (column.type()) {
+        case RLMPropertyTypeObject:
+        case RLMPropertyTypeArray:
+        case RLMPropertyTypeLinkingObjects:
+        case RLMPropertyTypeAny:
+            return false;
+        default:
+            break;
+    }
+    switch (operatorType) {
+        case NSEqualToPredicateOperatorType:
+        case NSLessThanPredicateOperatorType:
+        case NSLessThanOrEqualToPredicateOperatorType:
+        case NSGreaterThanPredicateOperatorType:
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+        case NSBeginsWithPredicateOperatorType:
+        case NSEndsWithPredicateOperatorType:
+        case NSContainsPredicateOperatorType:
+            break;
+        default:
+            return false;
+    }
+
+    RLMObjectSchema *targetSchema = column.object_schema_after_links();
+    Table& target = *targetSchema.table;
+    Query targetQuery = target.where();
+    add_constraint_to_query(targetQuery, column.type(), operatorType, predicateOptions,
+                            column.column_ignoring_links(), value);
+
+    auto linkColumns = column.link_column_indexes();
+    double depth = linkColumns.size();
+    double targetRows = target.size();
+    double forwardCost = std::max<double>(query.get_table()->size(), targetRows) * depth;
+    if (operatorType == NSEqualToPredicateOperatorType && target.has_search_index(column.index())) {
+        // Finding the matches through the index costs about one step per match, so going backwards costs
+        // matches * (1 + depth); count them only up to the point where that stops being cheaper
+        size_t limit = size_t(forwardCost / (1 + depth));
+        if (targetQuery.count(0, size_t(-1), limit) >= limit) {
+            return false;
+        }
+    }
+    else {
+        // Without statistics there's nothing to base the choice on, so keep the forward path
+        Group *group = targetSchema.realm.group;
+        if (!group || !ColumnStatistics::get(*group, target.get_name(), column.property().name.UTF8String)) {
+            return false;
+        }
+        NSPredicate *targetPredicate = [NSComparisonPredicate predicateWithLeftExpression:[NSExpression expressionForKeyPath:column.property().name]
+                                                                          rightExpression:[NSExpression expressionForConstantValue:value]
+                                                                                 modifier:NSDirectPredicateModifier
+                                                                                     type:operatorType
+                                                                                  options:predicateOptions];
+        double matches = estimated_selectivity(targetPredicate, targetSchema, *group) * targetRows;
+        if (targetRows + matches * depth >= forwardCost) {
+            return false;
+        }
+    }
+
+    query.and_query(std::unique_ptr<Expression>(new BacklinkExpression(std::move(linkColumns), std::move(targetQuery))));
+    return true;
+}
+
+// "property IN collection" over an int or string column can be evaluated with a single condition which looks the
+// values up in the search index or a hash set, rather than as a group of ored == conditions which each scan the
+// table. Returns false without modifying the query if the values can't be handled that way.
+bool add_in_constraint_to_query(realm::Query &query, const ColumnReference& column, NSComparisonPredicateOptions predicateOptions,
+                                id values, RLMObjectSchema *objectSchema, NSString *keyPath)
+{
+    if (column.has_links() || predicateOptions || ![values conformsToProtocol:@protocol(NSFastEnumeration)]) {
+        return false;
+    }
+
+    NSString *err = @"Expected object of type %@ in IN clause for property '%@' on object of type '%@', but received: %@";
+    switch (column.type()) {
+        case RLMPropertyTypeInt: {
+            std::vector<int64_t> ints;
+            for (id item in values) {
+                id normalized = value_from_constant_expression_or_value(item);
+                validate_property_value(column, normalized, err, objectSchema, keyPath);
+                if (normalized == NSNull.null) {
+                    return false;
+                }
+                ints.push_back([normalized longLongValue]);
+            }
+            query.in(column.index(), std::move(ints));
+            return true;
+        }
+        case RLMPropertyTypeString: {
+            // The StringData point into buffers owned by the NSStrings, and the condition copies them
+            std::vector<StringData> strings;
+            for (id item in values) {
+                id normalized = value_from_constant_expression_or_value(item);
+                validate_property_value(column, normalized, err, objectSchema, keyPath);
+                strings.push_back(normalized == NSNull.null ? StringData() : RLMStringDataWithNSString(normalized));
+            }
+            query.in(column.index(), std::move(strings));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
 void update_query_with_value_expression(RLMSchema *schema,
                                         RLMObjectSchema *desc,
                                         realm::Query &query,
@@ -983,6 +1249,9 @@ void update_query_with_value_expression(RLMSchema *schema,
 
     // turn "key.path IN collection" into ored together ==. "collection IN key.path" is handled elsewhere.
     if (pred.predicateOperatorType == NSInPredicateOperatorType) {
+        if (add_in_constraint_to_query(query, column, pred.options, value, desc, keyPath)) {
+            return;
+        }
         process_or_group(query, value, [&](id item) {
             id normalized = value_from_constant_expression_or_value(item);
             validate_property_value(column, normalized, @"Expected object of type %@ in IN clause for property '%@' on object of type '%@', but received: %@", desc, keyPath);
@@ -993,6 +1262,9 @@ void update_query_with_value_expression(RLMSchema *schema,
 
     validate_property_value(column, value, @"Expected object of type %@ for property '%@' on object of type '%@', but received: %@", desc, keyPath);
     if (pred.leftExpression.expressionType == NSKeyPathExpressionType) {
+        if (add_backlink_constraint_to_query(query, pred.predicateOperatorType, pred.options, column, value)) {
+            return;
+        }
         add_constraint_to_query(query, column.type(), pred.predicateOperatorType,
                                 pred.options, std::move(column), value);
     } else {
@@ -1108,6 +1380,113 @@ void update_query_with_function_expression(RLMSchema *schema, RLMObjectSchema *o
     }
 }
 
+// Estimated fraction of rows matched by a comparison between a property of the queried type and a constant,
+// based on the column statistics stored in the Realm. Returns 1 for anything that can't be estimated.
+double estimated_selectivity(NSPredicate *predicate, RLMObjectSchema *objectSchema, const Group& group) {
+    if (![predicate isMemberOfClass:[NSComparisonPredicate class]]) {
+        return 1;
+    }
+    NSComparisonPredicate *compp = (NSComparisonPredicate *)predicate;
+    if (compp.comparisonPredicateModifier != NSDirectPredicateModifier) {
+        return 1;
+    }
+
+    NSExpression *keyPathExpression = compp.leftExpression, *valueExpression = compp.rightExpression;
+    NSPredicateOperatorType operatorType = compp.predicateOperatorType;
+    if (keyPathExpression.expressionType == NSConstantValueExpressionType) {
+        std::swap(keyPathExpression, valueExpression);
+        if (operatorType == NSLessThanPredicateOperatorType || operatorType == NSLessThanOrEqualToPredicateOperatorType) {
+            operatorType = NSGreaterThanOrEqualToPredicateOperatorType;
+        }
+        else if (operatorType == NSGreaterThanPredicateOperatorType || operatorType == NSGreaterThanOrEqualToPredicateOperatorType) {
+            operatorType = NSLessThanOrEqualToPredicateOperatorType;
+        }
+    }
+    if (keyPathExpression.expressionType != NSKeyPathExpressionType
+        || (valueExpression.expressionType != NSConstantValueExpressionType && valueExpression.expressionType != NSAggregateExpressionType)
+        || [keyPathExpression.keyPath rangeOfString:@"."].location != NSNotFound) {
+        return 1;
+    }
+
+    auto stats = ColumnStatistics::get(group, objectSchema.table->get_name(), keyPathExpression.keyPath.UTF8String);
+    if (!stats) {
+        return 1;
+    }
+
+    auto number = [](id value, double *out) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            *out = [value doubleValue];
+            return true;
+        }
+        if ([value isKindOfClass:[NSDate class]]) {
+            *out = [value timeIntervalSince1970];
+            return true;
+        }
+        return false;
+    };
+
+    id value = value_from_constant_expression_or_value(valueExpression.constantValue);
+    if ([value isKindOfClass:[NSString class]]) {
+        if (operatorType == NSEqualToPredicateOperatorType) {
+            return stats->estimate_equal();
+        }
+        if (operatorType == NSNotEqualToPredicateOperatorType) {
+            return 1 - stats->estimate_equal();
+        }
+        return 1;
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    double v, to;
+    switch (operatorType) {
+        case NSEqualToPredicateOperatorType:
+            return number(value, &v) ? stats->estimate_equal(v) : 1;
+        case NSNotEqualToPredicateOperatorType:
+            return number(value, &v) ? 1 - stats->estimate_equal(v) : 1;
+        case NSLessThanPredicateOperatorType:
+        case NSLessThanOrEqualToPredicateOperatorType:
+            return number(value, &v) ? stats->estimate_range(-inf, v) : 1;
+        case NSGreaterThanPredicateOperatorType:
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+            return number(value, &v) ? stats->estimate_range(v, inf) : 1;
+        case NSBetweenPredicateOperatorType:
+            if ([value isKindOfClass:[NSArray class]] && [value count] == 2
+                && number(value_from_constant_expression_or_value([value firstObject]), &v)
+                && number(value_from_constant_expression_or_value([value lastObject]), &to)) {
+                return stats->estimate_range(v, to);
+            }
+            return 1;
+        default:
+            return 1;
+    }
+}
+
+// The query engine starts out scanning with the first condition of an AND group, and only learns over time which
+// condition rejects the most rows. When statistics are available, put the most selective conditions first.
+NSArray *subpredicates_by_selectivity(NSArray *subpredicates, RLMObjectSchema *objectSchema) {
+    Group *group = objectSchema.realm.group;
+    if (subpredicates.count < 2 || !group || !objectSchema.table) {
+        return subpredicates;
+    }
+
+    std::vector<std::pair<double, NSPredicate *>> estimates;
+    bool any_estimated = false;
+    for (NSPredicate *subp in subpredicates) {
+        double selectivity = estimated_selectivity(subp, objectSchema, *group);
+        any_estimated |= selectivity < 1;
+        estimates.emplace_back(selectivity, subp);
+    }
+    if (!any_estimated) {
+        return subpredicates;
+    }
+
+    std::stable_sort(estimates.begin(), estimates.end(), [](auto& a, auto& b) { return a.first < b.first; });
+    NSMutableArray *sorted = [NSMutableArray arrayWithCapacity:estimates.size()];
+    for (auto& estimate : estimates) {
+        [sorted addObject:estimate.second];
+    }
+    return sorted;
+}
 
 void update_query_with_predicate(NSPredicate *predicate, RLMSchema *schema,
                                  RLMObjectSchema *objectSchema, realm::Query &query)
@@ -1121,7 +1500,7 @@ void update_query_with_predicate(NSPredicate *predicate, RLMSchema *schema,
                 if (comp.subpredicates.count) {
                     // Add all of the subpredicates.
                     query.group();
-                    for (NSPredicate *subp in comp.subpredicates) {
+                    for (NSPredicate *subp in subpredicates_by_selectivity(comp.subpredicates, objectSchema)) {
                         update_query_with_predicate(subp, schema, objectSchema, query);
                     }
                     query.end_group();
@@ -580,6 +580,24 @@ REALM_NOINLINE void RLMRealmTranslateException(NSError **error) {
     }
 }
 
+/**
+ Computes the statistics used to pick the order in which the conditions of a query are evaluated,
+ for every object type which has none yet or has changed size considerably since they were computed.
+
+ Cannot be called from a write transaction, as it commits one of its own.
+
+ This reads every object of those types, so call it when the app is idle, e.g. after an import,
+ rather than after every write.
+ */
+- (void)updateQueryStatistics {
+    try {
+        _realm->update_statistics();
+    }
+    catch (std::exception const& ex) {
+        @throw RLMException(ex);
+    }
+}
+
 - (void)dealloc {
     if (_realm) {
         if (_realm->is_in_transaction()) {
@@ -181,7 +181,7 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
     if (const auto& sort = _results.get_sort()) {
         // A sort order is specified so we need to return the first match given that ordering.
         table_view = query.find_all();
-        table_view.sort(sort.column_indices, sort.ascending);
+        table_view.sort_by_keys(sort.column_indices, sort.ascending);
     } else {
         // No sort order is specified so we only need to find a single match.
         // FIXME: We're only looking for a single object so we'd like to be able to use `Query::find`
@@ -44,6 +44,7 @@ void RLMRealmTranslateException(NSError **error);
 - (void)sendNotifications:(NSString *)notification;
 - (void)verifyThread;
 - (void)verifyNotificationsAreSupported;
+- (void)updateQueryStatistics;
 
 + (NSString *)writeableTemporaryPathForFile:(NSString *)fileName;
 
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_COLUMN_STATISTICS_HPP
+#define REALM_COLUMN_STATISTICS_HPP
+
+#include <realm/string_data.hpp>
+#include <realm/util/optional.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace realm {
+class Group;
+class Table;
+
+// A summary of the values in one column, used to estimate how many rows a
+// condition on the column will match before running the query. Statistics are
+// stored in a hidden table in the Realm file, so they survive reopening it.
+//
+// Computing statistics scans the whole table, so it is never done implicitly:
+// Realm::update_statistics() computes them for the tables which have none, or
+// whose row count has drifted far enough from the count they were computed
+// at. Until then, queries use statistics which may be out of date, or none.
+struct ColumnStatistics {
+    static const size_t histogram_size = 8;
+
+    size_t row_count = 0;
+    size_t null_count = 0;
+    size_t distinct_count = 0; // Estimated, to within a few percent
+
+    // Only meaningful for numeric, bool and date columns. Dates are in seconds.
+    // The histogram splits [min, max] into equal-width buckets.
+    double min = 0;
+    double max = 0;
+    std::array<size_t, histogram_size> histogram{};
+
+    // Estimated fraction of rows whose value equals `value`
+    double estimate_equal(double value) const;
+    // Estimated fraction of rows which equal any one value; used for strings
+    double estimate_equal() const;
+    // Estimated fraction of rows whose value lies in [low, high]
+    double estimate_range(double low, double high) const;
+
+    static ColumnStatistics compute(const Table& table, size_t column);
+
+    // Compute and store statistics for every supported column of the table.
+    // Must be called within a write transaction.
+    static void update(Group& group, StringData table_name);
+
+    // True if the table has no stored statistics, or has grown or shrunk by
+    // more than a quarter since they were computed
+    static bool is_stale(const Group& group, StringData table_name);
+
+    static util::Optional<ColumnStatistics> get(const Group& group, StringData table_name, StringData column_name);
+};
+
+} // namespace realm
+
+#endif // REALM_COLUMN_STATISTICS_HPP
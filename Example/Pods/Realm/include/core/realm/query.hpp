@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <climits>
 #include <algorithm>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -57,6 +58,7 @@ class Array;
 class Expression;
 class SequentialGetterBase;
 class Group;
+class Query;
 
 struct QueryGroup {
     enum class State {
@@ -82,6 +84,79 @@ struct QueryGroup {
     State m_state = State::Default;
 };
 
+// What Query::profile() observed while running a query. Nodes are listed in
+// the order the conditions were added, and `schedule` lists every range the
+// engine handed to a node's aggregate_local(), in execution order, so it shows
+// how the scheduler alternated between conditions as their statistics changed.
+struct QueryProfile {
+    using Duration = std::chrono::steady_clock::duration;
+
+    struct Node {
+        size_t column = npos;     // Condition column, or npos for expressions and link conditions
+        bool uses_index = false;  // True if the node looks rows up (index, view) rather than scanning
+        size_t runs = 0;          // Number of ranges this node was asked to scan
+        size_t rows_scanned = 0;  // Sum of the lengths of those ranges
+        size_t matches = 0;       // Rows matching the whole query that were found while this node scanned
+        size_t probes = 0;        // Single rows tested on behalf of other nodes, where the node counts them
+        Duration time{};          // Time spent in this node's scans, including probing the other nodes
+        double match_distance = 0; // Final m_dD: average distance between local matches
+        double row_cost = 0;      // Final m_dT: cost of testing the next row
+        double cost = 0;          // Final cost() used to pick the next node to scan with
+    };
+
+    struct Step {
+        size_t node;       // Index into `nodes`
+        size_t begin;      // First row of the range
+        size_t end;        // Row at which the scan stopped
+        size_t matches;    // Matches found during this step
+        bool best;         // False if the step was only run to refresh the node's statistics
+    };
+
+    size_t matches = 0;
+    Duration time{};
+    std::vector<Node> nodes;
+    std::vector<Step> schedule;
+};
+
+// Yields the rows matching a query a batch at a time, straight from the query
+// nodes, for callers which go through the matches once (exporting, deleting,
+// serializing) and so have no use for a TableView holding all of them. Rows
+// come in the same order as from find_all(). Apart from deleting each batch as
+// described at batch_deleted(), the query and its table must not be modified
+// while the cursor is in use, and the query must not be run by anything else
+// meanwhile, as the cursor keeps its nodes initialized. Defined in
+// query_engine.hpp.
+class QueryCursor {
+public:
+    explicit QueryCursor(Query& query, size_t limit = size_t(-1), size_t batch_size = 1000);
+
+    // Replace `rows` with the next at most `batch_size` matching rows (table
+    // row indexes). Returns false, with `rows` empty, once all matches or
+    // `limit` of them have been returned. Stopping early needs no cleanup.
+    bool next(std::vector<size_t>& rows);
+
+    // Call after removing all of the rows of the last batch from the table,
+    // with Table::remove() or Table::move_last_over() in any order, to carry
+    // on with the rows which remain. The rows between the first and the last
+    // of the batch are scanned again, as move_last_over() may have moved rows
+    // which haven't been scanned yet there. Not supported for queries
+    // restricted by a view.
+    void batch_deleted();
+
+    size_t returned() const noexcept { return m_returned; }
+
+private:
+    Query& m_query;
+    size_t m_limit;
+    size_t m_batch_size;
+    size_t m_returned = 0;
+    size_t m_position = 0; // Next table row, or next entry of the restricting view
+    size_t m_end = 0;
+    size_t m_batch_begin = 0; // First row of the last batch
+    size_t m_batch_rows = 0;
+    bool m_started = false;
+};
+
 class Query {
 public:
     Query(const Table& table, TableViewBase* tv = nullptr);
@@ -203,6 +278,13 @@ public:
     Query& ends_with(size_t column_ndx, BinaryData value);
     Query& contains(size_t column_ndx, BinaryData value);
 
+    // Conditions: set membership. Matches rows whose value equals any of the
+    // given values, which is much faster than or-ing together one equal() per
+    // value. Uses the column's search index if it has one. Null strings match
+    // null. Defined in query_engine.hpp.
+    Query& in(size_t column_ndx, std::vector<int64_t> values);
+    Query& in(size_t column_ndx, std::vector<StringData> values);
+
     // Negation
     Query& Not();
 
@@ -228,6 +310,11 @@ public:
     // Aggregates
     size_t count(size_t start = 0, size_t end=size_t(-1), size_t limit = size_t(-1)) const;
 
+    // Count the matches the way count() does while recording how each condition was scheduled. This is slower
+    // than count() and meant for tuning conditions and indexes. Queries restricted by a TableView or LinkView are
+    // not scheduled, so only `matches` and `time` are filled in for them. Defined in query_engine.hpp.
+    QueryProfile profile(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
+
     int64_t sum_int(size_t column_ndx, size_t* resultcount = nullptr, size_t start = 0, size_t end = size_t(-1),
                     size_t limit = size_t(-1)) const;
 
@@ -392,6 +479,7 @@ private:
 
     friend class Table;
     friend class TableViewBase;
+    friend class QueryCursor;
 
     std::string error_code;
 
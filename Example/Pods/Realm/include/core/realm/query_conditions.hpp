@@ -127,8 +127,58 @@ struct NotEqual {
     bool operator()(A, B, C, D) const { REALM_ASSERT(false); return false; }
 };
 
+// The needle of a case-insensitive string condition, prepared once by whoever
+// holds the needle rather than by the condition for every row it compares: its
+// upper and lower case mappings, and whether it is ASCII, in which case only
+// the lower case form is used and just the haystack needs folding.
+class CaseFoldNeedle {
+public:
+    // Case maps `needle` itself
+    explicit CaseFoldNeedle(StringData needle):
+        value(needle), ascii(is_ascii(needle))
+    {
+        if (ascii) {
+            m_lower.resize(needle.size());
+            for (size_t i = 0; i < needle.size(); ++i)
+                m_lower[i] = ascii_fold(needle[i]);
+            upper = lower = m_lower.c_str();
+        }
+        else {
+            m_upper = case_map(needle, true, IgnoreErrors);
+            m_lower = case_map(needle, false, IgnoreErrors);
+            upper = m_upper.c_str();
+            lower = m_lower.c_str();
+        }
+    }
+
+    CaseFoldNeedle(const CaseFoldNeedle&) = delete;
+    CaseFoldNeedle& operator=(const CaseFoldNeedle&) = delete;
+
+    StringData value;
+    const char* upper;
+    const char* lower;
+    bool ascii;
+
+private:
+    std::string m_upper;
+    std::string m_lower;
+};
+
 // Does v2 contain v1?
 struct ContainsIns : public HackClass {
+    bool operator()(const CaseFoldNeedle& v1, StringData v2) const
+    {
+        if (v2.is_null() && !v1.value.is_null())
+            return false;
+
+        if (v1.value.size() == 0 && !v2.is_null())
+            return true;
+
+        if (v1.ascii)
+            return search_case_fold_ascii(v2, v1.lower, v1.value.size()) != v2.size();
+        return search_case_fold(v2, v1.upper, v1.lower, v1.value.size()) != v2.size();
+    }
+
     bool operator()(StringData v1, const char* v1_upper, const char* v1_lower, StringData v2, bool = false, bool = false) const
     {
         if (v2.is_null() && !v1.is_null())
@@ -163,6 +213,18 @@ struct ContainsIns : public HackClass {
 
 // Does v2 begin with v1?
 struct BeginsWithIns : public HackClass {
+    bool operator()(const CaseFoldNeedle& v1, StringData v2) const
+    {
+        if (v2.is_null() && !v1.value.is_null())
+            return false;
+
+        if (v1.value.size() > v2.size())
+            return false;
+        if (v1.ascii)
+            return equal_case_fold_ascii(v2.prefix(v1.value.size()), v1.lower);
+        return equal_case_fold(v2.prefix(v1.value.size()), v1.upper, v1.lower);
+    }
+
     bool operator()(StringData v1, const char* v1_upper, const char* v1_lower, StringData v2, bool = false, bool = false) const
     {
         if (v2.is_null() && !v1.is_null())
@@ -192,6 +254,18 @@ struct BeginsWithIns : public HackClass {
 
 // Does v2 end with v1?
 struct EndsWithIns : public HackClass {
+    bool operator()(const CaseFoldNeedle& v1, StringData v2) const
+    {
+        if (v2.is_null() && !v1.value.is_null())
+            return false;
+
+        if (v1.value.size() > v2.size())
+            return false;
+        if (v1.ascii)
+            return equal_case_fold_ascii(v2.suffix(v1.value.size()), v1.lower);
+        return equal_case_fold(v2.suffix(v1.value.size()), v1.upper, v1.lower);
+    }
+
     bool operator()(StringData v1, const char* v1_upper, const char* v1_lower, StringData v2, bool = false, bool = false) const
     {
         if (v2.is_null() && !v1.is_null())
@@ -221,6 +295,18 @@ struct EndsWithIns : public HackClass {
 };
 
 struct EqualIns : public HackClass {
+    bool operator()(const CaseFoldNeedle& v1, StringData v2) const
+    {
+        if (v1.value.is_null() != v2.is_null())
+            return false;
+
+        if (v1.value.size() != v2.size())
+            return false;
+        if (v1.ascii)
+            return equal_case_fold_ascii(v2, v1.lower);
+        return equal_case_fold(v2, v1.upper, v1.lower);
+    }
+
     bool operator()(StringData v1, const char* v1_upper, const char* v1_lower, StringData v2, bool = false, bool = false) const
     {
         if (v1.is_null() != v2.is_null())
@@ -250,6 +336,11 @@ struct EqualIns : public HackClass {
 };
 
 struct NotEqualIns : public HackClass {
+    bool operator()(const CaseFoldNeedle& v1, StringData v2) const
+    {
+        return !EqualIns()(v1, v2);
+    }
+
     bool operator()(StringData v1, const char* v1_upper, const char* v1_lower, StringData v2, bool = false, bool = false) const
     {
         if (v1.is_null() != v2.is_null())
@@ -114,6 +114,7 @@ AggregateState      State of the aggregate - contains a state variable that stor
 
 #include <iostream>
 #include <map>
+#include <unordered_set>
 
 #if _MSC_FULL_VER >= 160040219
 #  include <immintrin.h>
@@ -1780,6 +1781,307 @@ private:
     }
 };
 
+// Mirrors the scheduling loop of Query::count()/aggregate_internal(), timing and recording each aggregate_local()
+// call so that the choices the engine makes from the nodes' statistics can be inspected.
+inline QueryProfile Query::profile(size_t start, size_t end, size_t limit) const
+{
+    using clock = std::chrono::steady_clock;
+    QueryProfile profile;
+    auto began = clock::now();
+
+    if (m_view || !has_conditions() || limit == 0 || m_table->is_degenerate()) {
+        profile.matches = count(start, end, limit);
+        profile.time = clock::now() - began;
+        return profile;
+    }
+
+    if (end == size_t(-1))
+        end = m_table->size();
+
+    init(*m_table);
+    ParentNode* pn = root_node();
+    std::vector<ParentNode*>& children = pn->m_children;
+
+    profile.nodes.resize(children.size());
+    std::vector<size_t> initial_probes(children.size());
+    for (size_t c = 0; c < children.size(); c++) {
+        children[c]->aggregate_local_prepare(act_Count, ColumnTypeTraits<int64_t>::id, false);
+        initial_probes[c] = children[c]->m_probes;
+        profile.nodes[c].column = children[c]->m_condition_column_idx;
+    }
+
+    QueryState<int64_t> st;
+    st.init(act_Count, nullptr, limit);
+
+    auto run = [&](size_t c, size_t local_end, bool best) {
+        QueryProfile::Node& node = profile.nodes[c];
+        size_t matches_before = st.m_match_count;
+        auto step_began = clock::now();
+        size_t next = children[c]->aggregate_local(&st, start, local_end, best ? findlocals : probe_matches,
+                                                   nullptr);
+        node.time += clock::now() - step_began;
+
+        size_t stopped = next == not_found ? local_end : next;
+        node.runs++;
+        node.rows_scanned += stopped - start;
+        node.matches += st.m_match_count - matches_before;
+        profile.schedule.push_back({c, start, stopped, st.m_match_count - matches_before, best});
+        start = next;
+    };
+
+    while (start < end) {
+        size_t best = std::distance(children.begin(),
+                                    std::min_element(children.begin(), children.end(), ParentNode::score_compare()));
+
+        run(best, children[best]->m_dT == 0.0 ? end : std::min(start + 1000, end), true);
+
+        for (size_t c = 0; c < children.size() && start < end; c++) {
+            if (c == best)
+                continue;
+
+            double cost = children[c]->cost();
+            if (children[c]->m_dT < cost) {
+                size_t max_d = children[c]->m_dT == 0.0 ? end - start : bestdist;
+                run(c, children[c]->m_dT == 0.0 ? end : std::min(start + max_d, end), false);
+            }
+        }
+    }
+
+    for (size_t c = 0; c < children.size(); c++) {
+        QueryProfile::Node& node = profile.nodes[c];
+        node.uses_index = children[c]->m_dT == 0.0;
+        node.probes = children[c]->m_probes - initial_probes[c];
+        node.match_distance = children[c]->m_dD;
+        node.row_cost = children[c]->m_dT;
+        node.cost = children[c]->cost();
+    }
+
+    profile.matches = size_t(st.m_state);
+    profile.time = clock::now() - began;
+    return profile;
+}
+
+namespace _impl {
+// The values of an InExpression and a hash set to probe them with. Strings are
+// owned, as the caller's StringData may not outlive the query.
+template<class T>
+struct InValues {
+    std::vector<T> values;
+    std::unordered_set<T> set;
+
+    explicit InValues(std::vector<T> v)
+    {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+        values = std::move(v);
+        set.insert(values.begin(), values.end());
+    }
+    bool contains(T value) const { return set.count(value) != 0; }
+};
+
+template<>
+struct InValues<StringData> {
+    std::vector<util::Optional<std::string>> strings;
+    std::vector<StringData> values;
+    std::unordered_set<StringData> set;
+
+    explicit InValues(const std::vector<StringData>& v)
+    {
+        for (StringData value : v)
+            strings.push_back(value.is_null() ? util::none : util::make_optional(std::string(value)));
+        build();
+    }
+    InValues(const InValues& other) : strings(other.strings) { build(); }
+    InValues& operator=(const InValues&) = delete;
+
+    bool contains(StringData value) const { return set.count(value) != 0; }
+
+private:
+    void build()
+    {
+        for (auto& string : strings) {
+            StringData value = string ? StringData(*string) : StringData();
+            if (set.insert(value).second)
+                values.push_back(value);
+        }
+    }
+};
+} // namespace _impl
+
+// Query::in(). With a search index on the column, the rows holding each value
+// are looked up once and merged into a sorted list which is reused until the
+// table changes; without one, each row is probed against a hash set.
+template<class T>
+class InExpression : public Expression {
+public:
+    InExpression(const Table* table, size_t column, std::vector<T> values)
+    : m_table(table), m_column(column), m_values(std::move(values))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override
+    {
+        if (m_table->has_search_index(m_column)) {
+            refresh_rows();
+            auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+            return it != m_rows.end() && *it < end ? *it : not_found;
+        }
+
+        bool nullable = m_table->is_nullable(m_column);
+        for (; start < end; ++start) {
+            if (matches(start, nullable))
+                return start;
+        }
+        return not_found;
+    }
+
+    void set_base_table(const Table* table) override
+    {
+        m_table = table;
+        m_rows_version = uint_fast64_t(-1);
+    }
+    const Table* get_base_table() const override { return m_table; }
+
+    std::unique_ptr<Expression> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<Expression>(new InExpression(*this, patches));
+    }
+
+private:
+    InExpression(const InExpression& source, QueryNodeHandoverPatches* patches)
+    : m_table(patches ? nullptr : source.m_table), m_column(source.m_column), m_values(source.m_values)
+    {
+    }
+
+    bool matches(size_t row, bool nullable) const;
+    TableView find_all_equal(T value) const;
+
+    void refresh_rows() const
+    {
+        if (m_rows_version == m_table->get_version_counter())
+            return;
+        m_rows.clear();
+        for (T value : m_values.values) {
+            TableView view = find_all_equal(value);
+            for (size_t i = 0; i < view.size(); ++i)
+                m_rows.push_back(view.get_source_ndx(i));
+        }
+        std::sort(m_rows.begin(), m_rows.end());
+        m_rows_version = m_table->get_version_counter();
+    }
+
+    const Table* m_table;
+    size_t m_column;
+    _impl::InValues<T> m_values;
+
+    mutable std::vector<size_t> m_rows;
+    mutable uint_fast64_t m_rows_version = uint_fast64_t(-1);
+};
+
+template<>
+inline bool InExpression<int64_t>::matches(size_t row, bool nullable) const
+{
+    return !(nullable && m_table->is_null(m_column, row)) && m_values.contains(m_table->get_int(m_column, row));
+}
+
+template<>
+inline bool InExpression<StringData>::matches(size_t row, bool) const
+{
+    return m_values.contains(m_table->get_string(m_column, row));
+}
+
+template<>
+inline TableView InExpression<int64_t>::find_all_equal(int64_t value) const
+{
+    return const_cast<Table*>(m_table)->find_all_int(m_column, value);
+}
+
+template<>
+inline TableView InExpression<StringData>::find_all_equal(StringData value) const
+{
+    return const_cast<Table*>(m_table)->find_all_string(m_column, value);
+}
+
+inline Query& Query::in(size_t column_ndx, std::vector<int64_t> values)
+{
+    return and_query(Query(make_expression<InExpression<int64_t>>(get_table().get(), column_ndx, std::move(values))));
+}
+
+inline Query& Query::in(size_t column_ndx, std::vector<StringData> values)
+{
+    return and_query(Query(make_expression<InExpression<StringData>>(get_table().get(), column_ndx, std::move(values))));
+}
+
+inline QueryCursor::QueryCursor(Query& query, size_t limit, size_t batch_size)
+: m_query(query)
+, m_limit(limit)
+, m_batch_size(std::max<size_t>(batch_size, 1))
+{
+}
+
+inline bool QueryCursor::next(std::vector<size_t>& rows)
+{
+    rows.clear();
+    if (!m_started) {
+        m_started = true;
+        m_query.sync_view_if_needed();
+        if (!m_query.m_table || m_query.m_table->is_degenerate())
+            m_end = 0;
+        else
+            m_end = m_query.m_view ? m_query.m_view->size() : m_query.m_table->size();
+        if (m_end && m_query.has_conditions())
+            m_query.init(*m_query.m_table);
+    }
+
+    size_t want = std::min(m_batch_size, m_limit - m_returned);
+    ParentNode* node = m_query.has_conditions() ? m_query.root_node() : nullptr;
+    if (m_query.m_view) {
+        // As in Query::find(): test each row of the view on its own
+        while (rows.size() < want && m_position < m_end) {
+            int64_t ndx = m_query.m_view->m_row_indexes.get(m_position++);
+            if (ndx == detached_ref)
+                continue;
+            size_t row = size_t(ndx);
+            if (!node || node->find_first(row, row + 1) == row)
+                rows.push_back(row);
+        }
+    }
+    else {
+        while (rows.size() < want && m_position < m_end) {
+            size_t row = node ? node->find_first(m_position, m_end) : m_position;
+            if (row == not_found) {
+                m_position = m_end;
+                break;
+            }
+            rows.push_back(row);
+            m_position = row + 1;
+        }
+    }
+
+    m_batch_begin = rows.empty() ? m_position : rows.front();
+    m_batch_rows = rows.size();
+    m_returned += rows.size();
+    return !rows.empty();
+}
+
+inline void QueryCursor::batch_deleted()
+{
+    REALM_ASSERT(!m_query.m_view);
+    if (m_batch_rows == 0)
+        return;
+
+    // Rows before the first deleted one are where they were either way, and
+    // the rest have to be looked at again
+    m_position = m_batch_begin;
+    m_end -= m_batch_rows;
+    m_batch_rows = 0;
+    REALM_ASSERT_3(m_end, ==, m_query.m_table->size());
+
+    // The nodes cache the leaves they were scanning, which may be gone
+    if (m_end && m_query.has_conditions())
+        m_query.init(*m_query.m_table);
+}
+
 } // namespace realm
 
 #endif // REALM_QUERY_ENGINE_HPP
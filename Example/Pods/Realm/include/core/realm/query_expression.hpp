@@ -376,9 +376,26 @@ template<class TCond, class T, class TLeft = Subexpr, class TRight = Subexpr>
 class Compare;
 template<bool has_links>
 class UnaryLinkCompare;
+template<class TCond>
+class CaseFoldCompare;
 class ColumnAccessorBase;
 
 
+template<class Cond, class L, class R>
+Query create_compare(L left, const Subexpr2<R>& right, std::false_type)
+{
+    using CommonType = typename Common<L, R>::type;
+    using ValueType = typename std::conditional<std::is_same<L, StringData>::value, ConstantStringValue, Value<L>>::type;
+    return make_expression<Compare<Cond, CommonType>>(make_subexpr<ValueType>(left), right.clone());
+}
+
+// Case-insensitive string conditions, whose constant is case mapped here once rather than for every row
+template<class Cond, class L, class R>
+Query create_compare(L left, const Subexpr2<R>& right, std::true_type)
+{
+    return make_expression<CaseFoldCompare<Cond>>(left, right.clone());
+}
+
 // Handle cases where left side is a constant (int, float, int64_t, double, StringData)
 template<class L, class Cond, class R>
 Query create(L left, const Subexpr2<R>& right)
@@ -444,9 +461,11 @@ Query create(L left, const Subexpr2<R>& right)
 #endif
     {
         // Return query_expression.hpp node
-        using CommonType = typename Common<L, R>::type;
-        using ValueType = typename std::conditional<std::is_same<L, StringData>::value, ConstantStringValue, Value<L>>::type;
-        return make_expression<Compare<Cond, CommonType>>(make_subexpr<ValueType>(left), right.clone());
+        using CaseFold = std::integral_constant<bool, std::is_same<L, StringData>::value &&
+                                                      std::is_same<R, StringData>::value &&
+                                                      realm::is_any<Cond, ContainsIns, BeginsWithIns, EndsWithIns,
+                                                                    EqualIns, NotEqualIns>::value>;
+        return create_compare<Cond>(left, right, CaseFold());
     }
 }
 
@@ -2771,6 +2790,79 @@ private:
     std::unique_ptr<TRight> m_right;
 };
 
+// Compare<TCond, StringData> of a constant string with a string column for the
+// case-insensitive conditions, which keeps the constant as a CaseFoldNeedle so
+// that it is case mapped once when the query is built.
+template<class TCond>
+class CaseFoldCompare : public Expression
+{
+public:
+    CaseFoldCompare(StringData needle, std::unique_ptr<Subexpr> column) :
+        m_string(needle.is_null() ? util::none : util::make_optional(std::string(needle))),
+        m_needle(StringData(m_string)), m_column(std::move(column))
+    {
+    }
+
+    void set_base_table(const Table* table) override
+    {
+        m_column->set_base_table(table);
+    }
+
+    const Table* get_base_table() const override
+    {
+        return m_column->get_base_table();
+    }
+
+    size_t find_first(size_t start, size_t end) const override
+    {
+        TCond c;
+        Value<StringData> right;
+
+        for (; start < end;) {
+            m_column->evaluate(start, right);
+
+            if (right.m_from_link_list) {
+                // Match if at least 1 linked-to value fulfills the condition
+                for (size_t r = 0; r < right.m_values; r++) {
+                    if (c(m_needle, right.m_storage[r]))
+                        return start;
+                }
+                start += 1;
+            }
+            else {
+                size_t rows = minimum(right.m_values, end - start);
+                for (size_t m = 0; m < rows; m++) {
+                    if (c(m_needle, right.m_storage[m]))
+                        return start + m;
+                }
+                start += right.m_values;
+            }
+        }
+
+        return not_found; // no match
+    }
+
+    std::unique_ptr<Expression> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<Expression>(new CaseFoldCompare(*this, patches));
+    }
+
+    void apply_handover_patch(QueryNodeHandoverPatches& patches, Group& group) override
+    {
+        m_column->apply_handover_patch(patches, group);
+    }
+
+private:
+    CaseFoldCompare(const CaseFoldCompare& other, QueryNodeHandoverPatches* patches) :
+        m_string(other.m_string), m_needle(StringData(m_string)), m_column(other.m_column->clone(patches))
+    {
+    }
+
+    util::Optional<std::string> m_string;
+    CaseFoldNeedle m_needle;
+    std::unique_ptr<Subexpr> m_column;
+};
+
 }
 #endif // REALM_QUERY_EXPRESSION_HPP
 
@@ -25,6 +25,7 @@
 #include <string>
 #include <ostream>
 #include <cstring>
+#include <functional>
 
 #include <cfloat>
 #include <math.h>
@@ -324,4 +325,21 @@ inline StringData::operator bool() const noexcept
 
 } // namespace realm
 
+namespace std {
+
+template<>
+struct hash<::realm::StringData> {
+    size_t operator()(::realm::StringData s) const noexcept
+    {
+        uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+        for (size_t i = 0; i < s.size(); ++i) {
+            h ^= static_cast<unsigned char>(s[i]);
+            h *= 0x100000001b3ULL;
+        }
+        return size_t(h);
+    }
+};
+
+} // namespace std
+
 #endif // REALM_STRING_HPP
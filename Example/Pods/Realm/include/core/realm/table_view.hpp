@@ -316,6 +316,11 @@ public:
     // Sort m_row_indexes according to multiple columns
     void sort(std::vector<size_t> columns, std::vector<bool> ascending);
 
+    // Same as sort(columns, ascending), but extracts the values of the sort
+    // columns up front and radix sorts them (see RowIndexes::sort_by_keys()),
+    // which is much faster for large views. A re-sync re-sorts with sort().
+    void sort_by_keys(std::vector<size_t> columns, std::vector<bool> ascending);
+
     // Remove rows that are duplicated with respect to the column set passed as argument.
     // distinct() will preserve the original order of the row pointers, also if the order is a result of sort()
     // If two rows are indentical (for the given set of distinct-columns), then the last row is removed.
@@ -325,6 +330,11 @@ public:
     void distinct(size_t column);
     void distinct(std::vector<size_t> columns);
 
+    // Same as distinct(columns), but finds the duplicates with a hash set
+    // rather than by sorting (see RowIndexes::distinct_by_keys()), in
+    // expected linear time. A re-sync re-applies the distinct with distinct().
+    void distinct_by_keys(std::vector<size_t> columns);
+
     // Returns whether the rows are guaranteed to be in table order.
     // This is true only of unsorted TableViews created from either:
     // - Table::find_all()
@@ -808,6 +818,36 @@ inline size_t TableViewBase::find_by_source_ndx(size_t source_ndx) const noexcep
     return m_row_indexes.find_first(source_ndx);
 }
 
+inline void TableViewBase::sort_by_keys(std::vector<size_t> columns, std::vector<bool> ascending)
+{
+    REALM_ASSERT(columns.size() == ascending.size());
+    if (!m_distinct_columns.empty()) {
+        sort(std::move(columns), std::move(ascending));
+        return;
+    }
+
+    m_auto_sort = true;
+    m_sorting_predicate = Sorter(columns, ascending);
+    RowIndexes::sort_by_keys(m_sorting_predicate);
+}
+
+inline void TableViewBase::distinct_by_keys(std::vector<size_t> columns)
+{
+    // distinct() starts over from the unsorted contents of the view, which
+    // only a synced view without sort or distinct criteria already has
+    if (m_auto_sort || !m_distinct_columns.empty()) {
+        distinct(std::move(columns));
+        return;
+    }
+
+    sync_if_needed();
+    if (!RowIndexes::distinct_by_keys(columns)) {
+        distinct(std::move(columns));
+        return;
+    }
+    m_distinct_columns = std::move(columns);
+}
+
 inline TableViewBase::TableViewBase():
     RowIndexes(IntegerColumn::unattached_root_tag(), Allocator::get_default()) // Throws
 {
@@ -147,6 +147,69 @@ namespace realm {
     size_t search_case_fold(StringData haystack, const char* needle_upper,
         const char* needle_lower, size_t needle_size);
 
+    /// Returns true if \a s is plain 7-bit ASCII. For an ASCII needle the
+    /// case folding functions above reduce to folding the letters A-Z, as no
+    /// byte of a multi-byte UTF-8 character can match an ASCII character.
+    inline bool is_ascii(StringData s) noexcept
+    {
+        unsigned char bits = 0;
+        for (size_t i = 0; i < s.size(); ++i)
+            bits |= static_cast<unsigned char>(s[i]);
+        return bits < 0x80;
+    }
+
+    inline char ascii_fold(char c) noexcept
+    {
+        return unsigned(c - 'A') < 26 ? char(c | 0x20) : c;
+    }
+
+    /// Same as equal_case_fold() for an ASCII needle which has already been
+    /// folded to lower case, e.g. with ascii_fold(), and which must be the same
+    /// size as \a haystack. Only the haystack is folded.
+    inline bool equal_case_fold_ascii(StringData haystack, const char* needle_lower) noexcept
+    {
+        bool equal = true;
+        for (size_t i = 0; i < haystack.size(); ++i)
+            equal &= ascii_fold(haystack[i]) == needle_lower[i];
+        return equal;
+    }
+
+    /// Same as search_case_fold() for an ASCII needle which has already been
+    /// folded to lower case.
+    inline size_t search_case_fold_ascii(StringData haystack, const char* needle_lower, size_t needle_size) noexcept
+    {
+        if (needle_size == 0)
+            return 0;
+        if (needle_size > haystack.size())
+            return haystack.size();
+
+        const char* data = haystack.data();
+        const char first = needle_lower[0];
+        const char last = needle_lower[needle_size - 1];
+        const size_t positions = haystack.size() - needle_size + 1;
+
+        // Filter 16 positions at a time on their first and last byte, which
+        // compiles to a handful of vector compares, and only compare the whole
+        // needle at positions which pass
+        size_t i = 0;
+        for (; i + 16 <= positions; i += 16) {
+            unsigned mask = 0;
+            for (size_t j = 0; j < 16; ++j) {
+                bool candidate = (ascii_fold(data[i + j]) == first) & (ascii_fold(data[i + j + needle_size - 1]) == last);
+                mask |= unsigned(candidate) << j;
+            }
+            for (size_t j = 0; mask != 0; ++j, mask >>= 1) {
+                if ((mask & 1) && equal_case_fold_ascii(StringData(data + i + j, needle_size), needle_lower))
+                    return i + j;
+            }
+        }
+        for (; i < positions; ++i) {
+            if (ascii_fold(data[i]) == first && equal_case_fold_ascii(StringData(data + i, needle_size), needle_lower))
+                return i;
+        }
+        return haystack.size();
+    }
+
 
 } // namespace realm
 
@@ -1,10 +1,19 @@
 #ifndef REALM_VIEWS_HPP
 #define REALM_VIEWS_HPP
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <realm/column.hpp>
 #include <realm/column_string_enum.hpp>
 #include <realm/handover_defs.hpp>
 #include <realm/index_string.hpp>
+#include <realm/timestamp.hpp>
+#include <realm/unicode.hpp>
 
 namespace realm {
 
@@ -108,6 +117,20 @@ public:
 
     void sort(Sorter& sorting_predicate);
 
+    // Same result as sort(), but reads the values of the sort columns once per
+    // row into arrays of integer keys which order the same way (strings are
+    // replaced by their rank among the distinct values) and radix sorts those,
+    // so the sort itself never goes through the column accessors or compares
+    // strings. Falls back to sort() for columns it has no keys for.
+    void sort_by_keys(Sorter& sorting_predicate);
+
+    // Remove rows whose values in `columns` equal those of an earlier row,
+    // keeping the order of the remaining rows. Finds the duplicates with a
+    // hash set of the rows' keys as extracted for sort_by_keys(), rather than
+    // by sorting. Detached refs are kept. Returns false without changing
+    // anything for columns it has no keys for.
+    bool distinct_by_keys(const std::vector<size_t>& columns);
+
 #ifdef REALM_COOKIE_CHECK
     static const uint64_t cookie_expected = 0x7765697677777777ull; // 0x77656976 = 'view'; 0x77777777 = '7777' = alive
     uint64_t cookie;
@@ -116,6 +139,286 @@ public:
     IntegerColumn m_row_indexes;
 };
 
+namespace _impl {
+
+// Integer keys for the values of rows in some columns, most significant
+// first, for RowIndexes::sort_by_keys() and distinct_by_keys(). Each key holds
+// one value per row. Rows have equal keys if their values are equal, and if
+// `ordered`, rows are ordered by the unsigned value of their keys.
+class RowKeys {
+public:
+    explicit RowKeys(const std::vector<size_t>& rows, bool ordered = true) : m_rows(rows), m_ordered(ordered) { }
+
+    // Add the keys for one sort column. Returns false if the column type has
+    // no keys.
+    bool add_column(const ColumnBase& column, bool ascending)
+    {
+        // StringEnumColumn is a ColumnTemplate<int64_t> of keys, so check it first
+        if (auto c = dynamic_cast<const StringEnumColumn*>(&column))
+            return add_strings([=](size_t row) { return c->get(row); }, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<StringData>*>(&column))
+            return add_strings([=](size_t row) { return c->get_val(row); }, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<int64_t>*>(&column))
+            return add_values(*c, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<util::Optional<int64_t>>*>(&column))
+            return add_values(*c, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<float>*>(&column))
+            return add_values(*c, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<double>*>(&column))
+            return add_values(*c, ascending);
+        if (auto c = dynamic_cast<const ColumnTemplate<Timestamp>*>(&column))
+            return add_values(*c, ascending);
+        return false;
+    }
+
+    // Stable LSD radix sort of positions in `rows` by the keys
+    std::vector<size_t> sort() const
+    {
+        std::vector<size_t> order(m_rows.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::vector<size_t> buffer(order.size());
+        for (auto key = m_keys.rbegin(); key != m_keys.rend(); ++key)
+            radix_sort(*key, order, buffer);
+        return order;
+    }
+
+    // Positions in `rows` of the first row with each distinct combination of
+    // keys, in order
+    std::vector<size_t> unique() const
+    {
+        auto hash = [&](size_t i) {
+            uint64_t h = 0;
+            for (auto& key : m_keys)
+                h = (h ^ key[i]) * 0x9e3779b97f4a7c15ULL;
+            return size_t(h ^ (h >> 32));
+        };
+        auto equal = [&](size_t a, size_t b) {
+            for (auto& key : m_keys) {
+                if (key[a] != key[b])
+                    return false;
+            }
+            return true;
+        };
+        std::unordered_set<size_t, decltype(hash), decltype(equal)> seen(m_rows.size(), hash, equal);
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < m_rows.size(); ++i) {
+            if (seen.insert(i).second)
+                positions.push_back(i);
+        }
+        return positions;
+    }
+
+private:
+    static const uint64_t sign_bit = uint64_t(1) << 63;
+
+    static uint64_t key(int64_t value) noexcept { return uint64_t(value) ^ sign_bit; }
+    static uint64_t key(util::Optional<int64_t> value) noexcept { return key(*value); }
+    static uint64_t key(float value) noexcept { return key(double(value)); }
+    static uint64_t key(double value) noexcept
+    {
+        if (value == 0)
+            value = 0; // -0 and 0 compare equal
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return bits & sign_bit ? ~bits : bits | sign_bit;
+    }
+
+    // Nulls order before all values, as in ColumnTemplate::compare_values()
+    template<class T>
+    bool add_values(const ColumnTemplate<T>& column, bool ascending)
+    {
+        size_t n = m_rows.size();
+        std::vector<uint64_t> present(n), values(n);
+        bool has_nulls = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (column.is_null(m_rows[i])) {
+                has_nulls = true;
+                continue;
+            }
+            present[i] = 1;
+            values[i] = key(column.get_val(m_rows[i]));
+        }
+        if (has_nulls)
+            add_key(std::move(present), ascending);
+        add_key(std::move(values), ascending);
+        return true;
+    }
+
+    bool add_values(const ColumnTemplate<Timestamp>& column, bool ascending)
+    {
+        size_t n = m_rows.size();
+        std::vector<uint64_t> present(n), seconds(n), nanoseconds(n);
+        bool has_nulls = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (column.is_null(m_rows[i])) {
+                has_nulls = true;
+                continue;
+            }
+            Timestamp value = column.get_val(m_rows[i]);
+            present[i] = 1;
+            seconds[i] = key(value.get_seconds());
+            nanoseconds[i] = key(int64_t(value.get_nanoseconds()));
+        }
+        if (has_nulls)
+            add_key(std::move(present), ascending);
+        add_key(std::move(seconds), ascending);
+        add_key(std::move(nanoseconds), ascending);
+        return true;
+    }
+
+    // The key of a string is its rank among the distinct values in
+    // utf8_compare() order, so strings are only collated while sorting the
+    // distinct values, or just a number for each distinct value if the keys
+    // need not be ordered. Null has key 0.
+    template<class Get>
+    bool add_strings(Get get, bool ascending)
+    {
+        size_t n = m_rows.size();
+        std::vector<StringData> strings(n);
+        std::unordered_map<StringData, uint64_t> ranks;
+        for (size_t i = 0; i < n; ++i) {
+            strings[i] = get(m_rows[i]);
+            if (!strings[i].is_null())
+                ranks.emplace(strings[i], ranks.size() + 1);
+        }
+        if (m_ordered)
+            rank_strings(ranks);
+
+        std::vector<uint64_t> keys(n);
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = strings[i].is_null() ? 0 : ranks.find(strings[i])->second;
+        add_key(std::move(keys), ascending);
+        return true;
+    }
+
+    static void rank_strings(std::unordered_map<StringData, uint64_t>& ranks)
+    {
+        std::vector<StringData> distinct;
+        distinct.reserve(ranks.size());
+        for (auto& entry : ranks)
+            distinct.push_back(entry.first);
+        std::sort(distinct.begin(), distinct.end(), [](StringData a, StringData b) {
+            return utf8_compare(a, b);
+        });
+        uint64_t rank = 0;
+        for (size_t i = 0; i < distinct.size(); ++i) {
+            if (i == 0 || utf8_compare(distinct[i - 1], distinct[i]))
+                ++rank;
+            ranks[distinct[i]] = rank;
+        }
+    }
+
+    void add_key(std::vector<uint64_t> key, bool ascending)
+    {
+        if (!ascending) {
+            for (uint64_t& k : key)
+                k = ~k;
+        }
+        m_keys.push_back(std::move(key));
+    }
+
+    // One stable counting sort pass per byte of the key, skipping bytes which
+    // are the same for all rows
+    static void radix_sort(const std::vector<uint64_t>& key, std::vector<size_t>& order,
+                           std::vector<size_t>& buffer)
+    {
+        if (order.empty())
+            return;
+
+        std::vector<size_t> counts(8 * 256);
+        for (uint64_t k : key) {
+            for (int byte = 0; byte < 8; ++byte)
+                ++counts[byte * 256 + ((k >> (8 * byte)) & 0xff)];
+        }
+
+        for (int byte = 0; byte < 8; ++byte) {
+            size_t* count = &counts[byte * 256];
+            int shift = 8 * byte;
+            if (count[(key[order[0]] >> shift) & 0xff] == order.size())
+                continue;
+
+            size_t offset = 0;
+            for (size_t digit = 0; digit < 256; ++digit) {
+                size_t c = count[digit];
+                count[digit] = offset;
+                offset += c;
+            }
+            for (size_t i : order)
+                buffer[count[(key[i] >> shift) & 0xff]++] = i;
+            order.swap(buffer);
+        }
+    }
+
+    const std::vector<size_t>& m_rows;
+    bool m_ordered;
+    std::vector<std::vector<uint64_t>> m_keys;
+};
+
+} // namespace _impl
+
+inline void RowIndexes::sort_by_keys(Sorter& sorting_predicate)
+{
+    // Detached refs always go last, as in sort()
+    size_t sz = size();
+    std::vector<size_t> rows;
+    rows.reserve(sz);
+    for (size_t t = 0; t < sz; t++) {
+        int64_t ndx = m_row_indexes.get(t);
+        if (ndx != detached_ref)
+            rows.push_back(size_t(ndx));
+    }
+
+    _impl::RowKeys keys(rows);
+    for (size_t i = 0; i < sorting_predicate.m_column_indexes.size(); i++) {
+        const ColumnBase& column = get_column_base(sorting_predicate.m_column_indexes[i]);
+        if (!keys.add_column(column, sorting_predicate.m_ascending[i])) {
+            sort(sorting_predicate);
+            return;
+        }
+    }
+
+    size_t t = 0;
+    for (size_t i : keys.sort())
+        m_row_indexes.set(t++, int64_t(rows[i]));
+    for (; t < sz; t++)
+        m_row_indexes.set(t, detached_ref);
+}
+
+inline bool RowIndexes::distinct_by_keys(const std::vector<size_t>& columns)
+{
+    size_t sz = size();
+    std::vector<size_t> rows;
+    rows.reserve(sz);
+    for (size_t t = 0; t < sz; t++) {
+        int64_t ndx = m_row_indexes.get(t);
+        if (ndx != detached_ref)
+            rows.push_back(size_t(ndx));
+    }
+
+    _impl::RowKeys keys(rows, false);
+    for (size_t column : columns) {
+        if (!keys.add_column(get_column_base(column), true))
+            return false;
+    }
+
+    std::vector<bool> keep(rows.size());
+    for (size_t i : keys.unique())
+        keep[i] = true;
+
+    std::vector<int64_t> result;
+    result.reserve(sz);
+    size_t i = 0;
+    for (size_t t = 0; t < sz; t++) {
+        int64_t ndx = m_row_indexes.get(t);
+        if (ndx == detached_ref || keep[i++])
+            result.push_back(ndx);
+    }
+    m_row_indexes.clear();
+    for (int64_t ndx : result)
+        m_row_indexes.add(ndx);
+    return true;
+}
+
 } // namespace realm
 
 #endif // REALM_VIEWS_HPP
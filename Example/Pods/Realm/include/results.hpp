@@ -76,7 +76,8 @@ public:
     LinkViewRef get_linkview() const { return m_link_view; }
 
     // Get the size of this results
-    // Can be either O(1) or O(N) depending on the state of things
+    // Can be either O(1) or O(N) depending on the state of things, but never
+    // allocates row indexes for a query which has not been run yet
     size_t size();
 
     // Get the row accessor for the given index
@@ -192,6 +193,10 @@ private:
     void update_tableview();
     bool update_linkview();
 
+    // Compute first()/last() for Mode::Query without materializing a TableView
+    bool can_query_directly() const;
+    util::Optional<RowExpr> find_extreme_row(bool first);
+
     void validate_read() const;
     void validate_write() const;
 
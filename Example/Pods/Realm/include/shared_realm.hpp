@@ -123,6 +123,13 @@ namespace realm {
 
         void invalidate();
         bool compact();
+
+        // Compute the column statistics used to order query conditions (see
+        // ColumnStatistics) for every object type which has none or whose
+        // statistics are stale, in a write transaction of its own. This scans
+        // those tables in full, so call it when the app is idle rather than
+        // around every write. Cannot be called from a write transaction.
+        void update_statistics();
         void write_copy(StringData path, BinaryData encryption_key);
 
         std::thread::id thread_id() const { return m_thread_id; }
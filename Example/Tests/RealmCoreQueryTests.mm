@@ -0,0 +1,316 @@
+//
+//  RealmCoreQueryTests.mm
+//  MonkeyKit
+//
+//  Tests for the query and TableView additions to the Realm pod's core
+//  headers, run against in-memory groups. The results of the key-based sort
+//  and distinct are compared with the library's own sort() and distinct().
+//
+
+#import <XCTest/XCTest.h>
+
+#include <realm.hpp>
+#include <realm/query_engine.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace realm;
+
+namespace {
+enum Columns { col_Int, col_String, col_Double, col_Timestamp, col_Bool };
+
+// Rows with many ties and nulls in every column, so that both the order of
+// equal values and the position of nulls are exercised
+TableRef make_table(Group& group, size_t rows)
+{
+    TableRef table = group.add_table("rows");
+    table->add_column(type_Int, "int", true);
+    table->add_column(type_String, "string", true);
+    table->add_column(type_Double, "double", true);
+    table->add_column(type_Timestamp, "timestamp", true);
+    table->add_column(type_Bool, "bool");
+
+    const char* strings[] = {"b", "B", "a", "", "\xc3\xa4", "A", "ab", "aB", "\xc3\x85"};
+    table->add_empty_row(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        int64_t v = int64_t((i * 7919) % 13) - 6;
+        if (i % 11 == 0)
+            table->set_null(col_Int, i);
+        else
+            table->set_int(col_Int, i, v * 1000000007LL);
+
+        if (i % 10 == 0)
+            table->set_string(col_String, i, StringData());
+        else
+            table->set_string(col_String, i, strings[(i * 31) % 9]);
+
+        if (i % 9 == 0)
+            table->set_null(col_Double, i);
+        else
+            table->set_double(col_Double, i, v == 0 && i % 2 ? -0.0 : v / 4.0);
+
+        if (i % 8 == 0)
+            table->set_null(col_Timestamp, i);
+        else
+            table->set_timestamp(col_Timestamp, i, Timestamp(v, int32_t(v < 0 ? -1 : 1) * int32_t((i % 3) * 1000)));
+
+        table->set_bool(col_Bool, i, i % 3 == 0);
+    }
+    return table;
+}
+
+std::vector<size_t> source_rows(const TableView& view)
+{
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < view.size(); ++i)
+        rows.push_back(view.get_source_ndx(i));
+    return rows;
+}
+
+std::vector<size_t> matching_rows(Query query)
+{
+    return source_rows(query.find_all());
+}
+} // anonymous namespace
+
+@interface RealmCoreQueryTests : XCTestCase
+
+@end
+
+@implementation RealmCoreQueryTests
+
+- (void)assertSortByKeys:(TableRef)table columns:(std::vector<size_t>)columns ascending:(std::vector<bool>)ascending {
+    TableView expected = table->where().find_all();
+    expected.sort(columns, ascending);
+    TableView actual = table->where().find_all();
+    actual.sort_by_keys(columns, ascending);
+    XCTAssertTrue(source_rows(actual) == source_rows(expected));
+}
+
+- (void)testSortByKeysMatchesSortForEachColumnType {
+    Group group;
+    TableRef table = make_table(group, 500);
+    for (size_t column : {col_Int, col_String, col_Double, col_Timestamp, col_Bool}) {
+        [self assertSortByKeys:table columns:std::vector<size_t>{column} ascending:std::vector<bool>{true}];
+        [self assertSortByKeys:table columns:std::vector<size_t>{column} ascending:std::vector<bool>{false}];
+    }
+}
+
+- (void)testSortByKeysMatchesSortForSeveralColumns {
+    Group group;
+    TableRef table = make_table(group, 500);
+    [self assertSortByKeys:table columns:std::vector<size_t>{col_Bool, col_String} ascending:std::vector<bool>{true, false}];
+    [self assertSortByKeys:table columns:std::vector<size_t>{col_String, col_Int, col_Double} ascending:std::vector<bool>{false, true, true}];
+    [self assertSortByKeys:table columns:std::vector<size_t>{col_Timestamp, col_Int} ascending:std::vector<bool>{true, false}];
+}
+
+- (void)testSortByKeysKeepsTiesInViewOrderAndNullsFirst {
+    Group group;
+    TableRef table = group.add_table("rows");
+    table->add_column(type_Int, "int", true);
+    table->add_empty_row(6);
+    table->set_int(0, 0, 2);
+    table->set_null(0, 1);
+    table->set_int(0, 2, 1);
+    table->set_int(0, 3, 2);
+    table->set_null(0, 4);
+    table->set_int(0, 5, 1);
+
+    TableView view = table->where().find_all();
+    view.sort_by_keys({0}, {true});
+    XCTAssertTrue(source_rows(view) == (std::vector<size_t>{1, 4, 2, 5, 0, 3}));
+    view.sort(0, true);
+    XCTAssertTrue(source_rows(view) == (std::vector<size_t>{1, 4, 2, 5, 0, 3}));
+
+    view = table->where().find_all();
+    view.sort_by_keys({0}, {false});
+    XCTAssertTrue(source_rows(view) == (std::vector<size_t>{0, 3, 2, 5, 1, 4}));
+    view.sort(0, false);
+    XCTAssertTrue(source_rows(view) == (std::vector<size_t>{0, 3, 2, 5, 1, 4}));
+}
+
+- (void)testSortByKeysCriteriaAreKeptBySync {
+    Group group;
+    TableRef table = make_table(group, 200);
+    TableView view = table->where().find_all();
+    view.sort_by_keys({col_String, col_Int}, {true, true});
+
+    table->set_string(col_String, 3, "0");
+    table->move_last_over(7);
+    view.sync_if_needed();
+
+    TableView expected = table->where().find_all();
+    expected.sort({col_String, col_Int}, {true, true});
+    XCTAssertTrue(source_rows(view) == source_rows(expected));
+}
+
+- (void)testDistinctByKeysMatchesDistinct {
+    Group group;
+    TableRef table = make_table(group, 500);
+    for (auto columns : std::vector<std::vector<size_t>>{{col_Int}, {col_String}, {col_Double}, {col_Timestamp},
+                                                        {col_Bool, col_String}, {col_Int, col_Timestamp}}) {
+        TableView expected = table->where().find_all();
+        expected.distinct(columns);
+        TableView actual = table->where().find_all();
+        actual.distinct_by_keys(columns);
+        XCTAssertTrue(source_rows(actual) == source_rows(expected));
+    }
+}
+
+- (void)testDistinctByKeysAfterSortKeepsFirstOfSortedDuplicates {
+    Group group;
+    TableRef table = make_table(group, 300);
+    TableView expected = table->where().find_all();
+    expected.sort(col_Int, false);
+    expected.distinct(col_String);
+    TableView actual = table->where().find_all();
+    actual.sort_by_keys({col_Int}, {false});
+    actual.distinct_by_keys({col_String});
+    XCTAssertTrue(source_rows(actual) == source_rows(expected));
+}
+
+- (void)testQueryCursorReturnsMatchesInFindAllOrder {
+    Group group;
+    TableRef table = make_table(group, 1000);
+    Query query = table->where().greater(col_Int, 0).equal(col_Bool, false);
+    std::vector<size_t> expected = matching_rows(query);
+    XCTAssertGreaterThan(expected.size(), 10u);
+
+    for (size_t batch_size : {1, 7, 1000}) {
+        QueryCursor cursor(query, size_t(-1), batch_size);
+        std::vector<size_t> rows, all;
+        while (cursor.next(rows)) {
+            XCTAssertLessThanOrEqual(rows.size(), batch_size);
+            all.insert(all.end(), rows.begin(), rows.end());
+        }
+        XCTAssertTrue(all == expected);
+        XCTAssertEqual(cursor.returned(), expected.size());
+    }
+}
+
+- (void)testQueryCursorStopsAtLimit {
+    Group group;
+    TableRef table = make_table(group, 1000);
+    Query query = table->where().greater(col_Int, 0);
+    std::vector<size_t> expected = matching_rows(query);
+    expected.resize(10);
+
+    QueryCursor cursor(query, 10, 4);
+    std::vector<size_t> rows, all;
+    while (cursor.next(rows))
+        all.insert(all.end(), rows.begin(), rows.end());
+    XCTAssertTrue(all == expected);
+    XCTAssertTrue(rows.empty());
+}
+
+- (void)testQueryCursorWithoutConditionsReturnsEveryRow {
+    Group group;
+    TableRef table = make_table(group, 25);
+    Query query = table->where();
+    QueryCursor cursor(query, size_t(-1), 10);
+    std::vector<size_t> rows, all;
+    while (cursor.next(rows))
+        all.insert(all.end(), rows.begin(), rows.end());
+    XCTAssertEqual(all.size(), 25u);
+    XCTAssertEqual(all.back(), 24u);
+}
+
+- (void)testQueryCursorBatchDeletedAfterMoveLastOver {
+    Group group;
+    TableRef table = make_table(group, 1000);
+    size_t non_matching = table->where().Not().greater(col_Int, 0).count();
+
+    Query query = table->where().greater(col_Int, 0);
+    QueryCursor cursor(query, size_t(-1), 16);
+    std::vector<size_t> rows;
+    size_t deleted = 0;
+    while (cursor.next(rows)) {
+        // move_last_over() must go backwards so that the rows still to be
+        // deleted are not the ones being moved
+        for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
+            XCTAssertGreaterThan(table->get_int(col_Int, *it), 0);
+            table->move_last_over(*it);
+        }
+        deleted += rows.size();
+        cursor.batch_deleted();
+    }
+
+    XCTAssertEqual(table->where().greater(col_Int, 0).count(), 0u);
+    XCTAssertEqual(table->size(), non_matching);
+    XCTAssertEqual(deleted + non_matching, 1000u);
+}
+
+- (void)testQueryCursorBatchDeletedAfterRemove {
+    Group group;
+    TableRef table = make_table(group, 1000);
+    std::vector<size_t> kept = matching_rows(table->where().Not().equal(col_Bool, true));
+    std::vector<int64_t> kept_values;
+    for (size_t row : kept)
+        kept_values.push_back(table->get_int(col_Int, row));
+
+    Query query = table->where().equal(col_Bool, true);
+    QueryCursor cursor(query, size_t(-1), 16);
+    std::vector<size_t> rows;
+    while (cursor.next(rows)) {
+        for (auto it = rows.rbegin(); it != rows.rend(); ++it)
+            table->remove(*it);
+        cursor.batch_deleted();
+    }
+
+    // remove() keeps the order of the remaining rows
+    XCTAssertEqual(table->size(), kept.size());
+    for (size_t i = 0; i < kept.size() && i < table->size(); ++i) {
+        XCTAssertEqual(table->get_int(col_Int, i), kept_values[i]);
+        XCTAssertFalse(table->get_bool(col_Bool, i));
+    }
+}
+
+- (void)testInMatchesOredEquals {
+    Group group;
+    TableRef table = make_table(group, 500);
+
+    Query ored = table->where().group().equal(col_Int, 0).Or().equal(col_Int, int64_t(2 * 1000000007LL)).end_group();
+    Query in = table->where().in(col_Int, {0, int64_t(2 * 1000000007LL), 12345});
+    XCTAssertTrue(matching_rows(in) == matching_rows(ored));
+
+    ored = table->where().group().equal(col_String, "a").Or().equal(col_String, StringData()).end_group();
+    in = table->where().in(col_String, {StringData("a"), StringData()});
+    XCTAssertTrue(matching_rows(in) == matching_rows(ored));
+
+    table->add_search_index(col_String);
+    XCTAssertTrue(matching_rows(table->where().in(col_String, {StringData("a"), StringData()})) == matching_rows(ored));
+}
+
+- (void)testProfileCountsLikeCount {
+    Group group;
+    TableRef table = make_table(group, 2000);
+    Query query = table->where().greater(col_Int, 0).equal(col_Bool, false).not_equal(col_String, "a");
+    QueryProfile profile = query.profile();
+    XCTAssertEqual(profile.matches, query.count());
+    XCTAssertEqual(profile.nodes.size(), 3u);
+    XCTAssertFalse(profile.schedule.empty());
+}
+
+- (void)testSortPerformance {
+    Group group;
+    TableRef table = make_table(group, 100000);
+    TableView view = table->where().find_all();
+    [self measureBlock:^{
+        TableView sorted = view;
+        sorted.sort({col_String, col_Int}, {true, true});
+    }];
+}
+
+- (void)testSortByKeysPerformance {
+    Group group;
+    TableRef table = make_table(group, 100000);
+    TableView view = table->where().find_all();
+    [self measureBlock:^{
+        TableView sorted = view;
+        sorted.sort_by_keys({col_String, col_Int}, {true, true});
+    }];
+}
+
+@end
@@ -0,0 +1,241 @@
+//
+//  RealmResultsTests.m
+//  MonkeyKit
+//
+//  Tests for the changes to sorting, firstObject/lastObject and query
+//  evaluation in the Realm pod, through its Objective-C API on in-memory
+//  Realms. Each query is checked against an equivalent one which takes the
+//  original path.
+//
+
+#import <XCTest/XCTest.h>
+#import <Realm/Realm.h>
+#import <Realm/RLMRealm_Private.h>
+
+@interface RRTDog : RLMObject
+@property NSString *name;
+@property NSInteger tag;
+@property NSNumber<RLMInt> *age;
+@property NSNumber<RLMDouble> *weight;
+@property NSDate *born;
+@property NSString *note;
+@end
+
+@implementation RRTDog
+@end
+
+RLM_ARRAY_TYPE(RRTDog)
+
+@interface RRTOwner : RLMObject
+@property NSString *name;
+@property NSInteger score;
+@property RRTDog *dog;
+@property RLMArray<RRTDog *><RRTDog> *dogs;
+@end
+
+@implementation RRTOwner
+@end
+
+static NSArray *tagsOf(id<NSFastEnumeration> objects) {
+    NSMutableArray *tags = [NSMutableArray array];
+    for (id object in objects) {
+        [tags addObject:[object valueForKey:@"tag"]];
+    }
+    return tags;
+}
+
+static NSArray *namesOf(id<NSFastEnumeration> objects) {
+    NSMutableArray *names = [NSMutableArray array];
+    for (id object in objects) {
+        [names addObject:[object valueForKey:@"name"] ?: NSNull.null];
+    }
+    return names;
+}
+
+@interface RealmResultsTests : XCTestCase
+@property (nonatomic, strong) RLMRealm *realm;
+@end
+
+@implementation RealmResultsTests
+
+- (void)setUp {
+    [super setUp];
+    RLMRealmConfiguration *configuration = [[RLMRealmConfiguration alloc] init];
+    configuration.inMemoryIdentifier = [NSUUID UUID].UUIDString;
+    configuration.objectClasses = @[RRTDog.class, RRTOwner.class];
+    self.realm = [RLMRealm realmWithConfiguration:configuration error:nil];
+}
+
+- (void)tearDown {
+    self.realm = nil;
+    [super tearDown];
+}
+
+// Dogs with many equal values and some nulls in each property
+- (void)addDogs:(NSInteger)count {
+    NSArray *names = @[@"Rex", @"rEXY", @"Bärbel", @"BÄR", @"max", @"Max", @"", @"a"];
+    [self.realm beginWriteTransaction];
+    for (NSInteger i = 0; i < count; i++) {
+        NSInteger v = (i * 7919) % 13 - 6;
+        [RRTDog createInRealm:self.realm withValue:@{@"name": i % 10 ? names[(i * 31) % names.count] : NSNull.null,
+                                                     @"tag": @(i),
+                                                     @"age": i % 11 ? @(v) : NSNull.null,
+                                                     @"weight": i % 9 ? @(v / 4.0) : NSNull.null,
+                                                     @"born": i % 8 ? [NSDate dateWithTimeIntervalSince1970:v * 1000] : NSNull.null}];
+    }
+    [self.realm commitWriteTransaction];
+}
+
+- (void)addOwners:(NSInteger)count {
+    RLMResults *dogs = [RRTDog allObjectsInRealm:self.realm];
+    [self.realm beginWriteTransaction];
+    for (NSInteger i = 0; i < count; i++) {
+        RRTOwner *owner = [RRTOwner createInRealm:self.realm withValue:@{@"name": [NSString stringWithFormat:@"owner %ld", (long)i],
+                                                                         @"score": @(i % 17)}];
+        if (i % 4) {
+            owner.dog = dogs[(i * 3) % dogs.count];
+        }
+        for (NSInteger j = 0; j < i % 5; j++) {
+            [owner.dogs addObject:dogs[(i * 7 + j) % dogs.count]];
+        }
+    }
+    [self.realm commitWriteTransaction];
+}
+
+- (void)testSortOrdersNullsFirstAndKeepsTiesInInsertionOrder {
+    NSArray *ages = @[@2, NSNull.null, @1, @2, NSNull.null, @1];
+    [self.realm beginWriteTransaction];
+    for (NSUInteger i = 0; i < ages.count; i++) {
+        [RRTDog createInRealm:self.realm withValue:@{@"tag": @(i), @"age": ages[i]}];
+    }
+    [self.realm commitWriteTransaction];
+
+    RLMResults *dogs = [RRTDog allObjectsInRealm:self.realm];
+    XCTAssertEqualObjects(tagsOf([dogs sortedResultsUsingProperty:@"age" ascending:YES]), (@[@1, @4, @2, @5, @0, @3]));
+    XCTAssertEqualObjects(tagsOf([dogs sortedResultsUsingProperty:@"age" ascending:NO]), (@[@0, @3, @2, @5, @1, @4]));
+}
+
+// The first sort of a Results goes through TableView::sort_by_keys(), while a
+// re-sync after a write re-sorts with the original TableView::sort()
+- (void)testSortMatchesResortAfterWrite {
+    [self addDogs:500];
+    NSArray *sorts = @[@[[RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:YES]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:NO]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"weight" ascending:YES]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"born" ascending:NO]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:YES],
+                         [RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:NO]]];
+    RRTDog *dog = [[RRTDog allObjectsInRealm:self.realm] firstObject];
+    for (NSArray *sort in sorts) {
+        RLMResults *results = [[RRTDog allObjectsInRealm:self.realm] sortedResultsUsingDescriptors:sort];
+        NSArray *sorted = tagsOf(results);
+
+        [self.realm beginWriteTransaction];
+        dog.note = [sort description];
+        [self.realm commitWriteTransaction];
+        XCTAssertEqualObjects(tagsOf(results), sorted);
+    }
+}
+
+- (void)testFirstAndLastObjectMatchEnumeration {
+    [self addDogs:3000];
+    NSArray *queries = @[@"age > 4", @"tag < 5", @"tag > 2990", @"name == 'max' AND age == 2", @"tag < 0"];
+    NSArray *sorts = @[@[],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:YES]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:NO]],
+                       @[[RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:YES],
+                         [RLMSortDescriptor sortDescriptorWithProperty:@"weight" ascending:NO]]];
+    for (NSString *query in queries) {
+        for (NSArray *sort in sorts) {
+            RLMResults *results = [RRTDog objectsInRealm:self.realm where:query];
+            RLMResults *enumerated = [RRTDog objectsInRealm:self.realm where:query];
+            if (sort.count) {
+                results = [results sortedResultsUsingDescriptors:sort];
+                enumerated = [enumerated sortedResultsUsingDescriptors:sort];
+            }
+            NSArray *expected = tagsOf(enumerated);
+            XCTAssertEqualObjects([results.firstObject valueForKey:@"tag"], expected.firstObject, @"%@ %@", query, sort);
+            XCTAssertEqualObjects([results.lastObject valueForKey:@"tag"], expected.lastObject, @"%@ %@", query, sort);
+        }
+    }
+}
+
+- (void)testInMatchesOredEquals {
+    [self addDogs:500];
+    NSArray *pairs = @[@[@"tag IN %@", @[@1, @5, @499, @-1], @"tag == 1 OR tag == 5 OR tag == 499 OR tag == -1"],
+                       @[@"age IN %@", @[@-6, @0, @6], @"age == -6 OR age == 0 OR age == 6"],
+                       @[@"age IN %@", @[@1, NSNull.null], @"age == 1 OR age == nil"],
+                       @[@"name IN %@", @[@"max", @"Rex", @""], @"name == 'max' OR name == 'Rex' OR name == ''"],
+                       @[@"name IN %@", @[@"a", NSNull.null], @"name == 'a' OR name == nil"],
+                       @[@"name IN %@", @[], @"FALSEPREDICATE"]];
+    for (NSArray *pair in pairs) {
+        RLMResults *matched = [RRTDog objectsInRealm:self.realm withPredicate:[NSPredicate predicateWithFormat:pair[0], pair[1]]];
+        RLMResults *ored = [RRTDog objectsInRealm:self.realm where:pair[2]];
+        XCTAssertEqualObjects(tagsOf(matched), tagsOf(ored), @"%@", pair[2]);
+    }
+}
+
+// Conditions through links go through query expressions, and may be
+// evaluated backwards from the linked table once there are statistics; both
+// must match the owners of the dogs found by the same condition on RRTDog
+- (void)testLinkQueriesMatchConditionOnLinkedObjects {
+    [self addDogs:400];
+    [self addOwners:300];
+    NSArray *conditions = @[@"name CONTAINS[c] 'ä'", @"name BEGINSWITH[c] 'RE'", @"name ==[c] 'max'",
+                            @"name ENDSWITH[c] 'xy'", @"name == 'Max'", @"age > 4", @"tag < 10"];
+    RLMResults *owners = [RRTOwner allObjectsInRealm:self.realm];
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            [self.realm updateQueryStatistics];
+        }
+        for (NSString *condition in conditions) {
+            NSSet *dogs = [NSSet setWithArray:tagsOf([RRTDog objectsInRealm:self.realm where:condition])];
+            NSMutableArray *one = [NSMutableArray array], *any = [NSMutableArray array];
+            for (RRTOwner *owner in owners) {
+                if (owner.dog && [dogs containsObject:@(owner.dog.tag)]) {
+                    [one addObject:owner.name];
+                }
+                for (RRTDog *dog in owner.dogs) {
+                    if ([dogs containsObject:@(dog.tag)]) {
+                        [any addObject:owner.name];
+                        break;
+                    }
+                }
+            }
+
+            NSString *query = [@"dog." stringByAppendingString:condition];
+            XCTAssertEqualObjects(namesOf([RRTOwner objectsInRealm:self.realm where:query]), one, @"%@", query);
+            query = [@"ANY dogs." stringByAppendingString:condition];
+            XCTAssertEqualObjects(namesOf([RRTOwner objectsInRealm:self.realm where:query]), any, @"%@", query);
+        }
+    }
+}
+
+- (void)testQueryStatisticsDoNotChangeResults {
+    [self addDogs:2000];
+    NSArray *queries = @[@"age > 4 AND tag < 1500 AND name == 'max'",
+                         @"name != 'Rex' AND weight < 0 AND born > %@",
+                         @"tag BETWEEN {100, 200} AND age == 3 OR name == nil AND age < -5"];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:-2000];
+    NSMutableArray *before = [NSMutableArray array];
+    for (NSString *query in queries) {
+        [before addObject:tagsOf([RRTDog objectsInRealm:self.realm where:query, date])];
+    }
+
+    [self.realm updateQueryStatistics];
+    for (NSUInteger i = 0; i < queries.count; i++) {
+        XCTAssertEqualObjects(tagsOf([RRTDog objectsInRealm:self.realm where:queries[i], date]), before[i], @"%@", queries[i]);
+    }
+}
+
+- (void)testSortPerformance {
+    [self addDogs:100000];
+    [self measureBlock:^{
+        RLMResults *results = [[RRTDog allObjectsInRealm:self.realm] sortedResultsUsingDescriptors:@[[RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:YES],
+                                                                                                      [RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:YES]]];
+        [results objectAtIndex:0];
+    }];
+}
+
+@end